@@ -0,0 +1,117 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+#ifndef APRSINJECT_ACKTRACKER_H
+#define APRSINJECT_ACKTRACKER_H
+
+#include <string>
+#include <deque>
+
+#include <time.h>
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** General Defines                                                      **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Structures                                                           **
+ **************************************************************************/
+
+  // One per STOMP frame, every Result parsed from the frame holds a
+  // reference and gives it back once it has been committed or dropped.
+  // The counter is touched from both ingest and inject threads so it
+  // can't use openframe::Refcount.
+  class FrameAck {
+    public:
+      FrameAck(const std::string &message_id) : _message_id(message_id), _refs(1) { }
+
+      const std::string &message_id() const { return _message_id; }
+
+      void retain() { __sync_add_and_fetch(&_refs, 1); }
+      void release() {
+        if (__sync_sub_and_fetch(&_refs, 1) == 0) delete this;
+      } // release
+
+      // only the tracker is left holding us, every result is done
+      bool is_done() const { return _refs == 1; }
+
+    private:
+      ~FrameAck() { }
+
+      std::string _message_id;
+      volatile int _refs;
+  }; // class FrameAck
+
+  class AckTracker {
+    public:
+      enum ackModeEnum {
+        ackModeFrame		= 0,	// ack as soon as the frame is parsed
+        ackModeIndividual	= 1,	// ack each frame once committed
+        ackModeCumulative	= 2	// ack the newest committed frame
+      }; // ackModeEnum
+
+      static const size_t kDefaultBatch;
+      static const time_t kDefaultInterval;
+
+      AckTracker(const ackModeEnum mode, const size_t batch=kDefaultBatch, const time_t interval=kDefaultInterval);
+      virtual ~AckTracker();
+
+      typedef std::deque<FrameAck *> frames_t;
+      typedef frames_t::iterator frames_itr;
+      typedef frames_t::const_iterator frames_citr;
+      typedef frames_t::size_type frames_st;
+
+      typedef std::deque<std::string> acks_t;
+      typedef acks_t::iterator acks_itr;
+      typedef acks_t::const_iterator acks_citr;
+      typedef acks_t::size_type acks_st;
+
+      static ackModeEnum string_to_mode(const std::string &mode);
+
+      ackModeEnum mode() const { return _mode; }
+      bool is_mode(const ackModeEnum mode) const { return _mode == mode; }
+      frames_st pending() const { return _frames.size(); }
+
+      FrameAck *track(const std::string &message_id);
+      void reset();
+      size_t collect(acks_t &acks, const bool force=false);
+
+    protected:
+    private:
+      ackModeEnum _mode;
+      size_t _batch;
+      time_t _interval;
+      time_t _last_collect_at;
+      frames_t _frames;
+  }; // class AckTracker
+
+/**************************************************************************
+ ** Macro's                                                              **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Proto types                                                          **
+ **************************************************************************/
+} // namespace aprsinject
+#endif
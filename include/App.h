@@ -8,6 +8,8 @@
 #include <openframe/App/Application.h>
 #include <stomp/StompStats.h>
 
+#include "Worker.h"
+
 namespace aprsinject {
 /**************************************************************************
  ** General Defines                                                      **
@@ -16,16 +18,42 @@ namespace aprsinject {
 /**************************************************************************
  ** Structures                                                           **
  **************************************************************************/
+  class ResultQueue;
+  class ResultPool;
+  class ShardRouter;
+  class DuplicateTable;
+  class StationTable;
+  class IdCache;
+  class Preloader;
+  class IdSnapshot;
+  class SingleFlight;
+
   class App : public openframe::App::Application {
     public:
       typedef openframe::App::Application super;
 
-      typedef std::deque<pthread_t> workers_t;
+      // one per worker thread, stop asks just that worker to finish
+      // up and load is what it last published about itself
+      struct worker_t {
+        pthread_t thread_id;
+        unsigned int id;
+        int stage;
+        volatile bool stop;
+        WorkerLoad load;
+      }; // worker_t
+
+      typedef std::deque<worker_t *> workers_t;
       typedef workers_t::iterator workers_itr;
       typedef workers_t::const_iterator workers_citr;
       typedef workers_t::size_type workers_st;
 
       static const char *kPidFile;
+      static const time_t kDefaultScaleInterval;
+      static const int kDefaultScaleLagHigh;
+      static const int kDefaultScaleLagLow;
+      static const int kDefaultScaleBacklogHigh;
+      static const int kDefaultScaleBacklogLow;
+      static const int kDefaultScaleIdleRounds;
 
       App(const std::string &prompt, const std::string &config, const bool console=false);
       virtual ~App();
@@ -52,13 +80,41 @@ namespace aprsinject {
       bool onRun();
 
       static void *WorkerThread(void *arg);
+      static void *ScalerThread(void *arg);
+      void start_worker(const unsigned int id, const int stage, ResultQueue *queue=NULL);
+      void stop_worker(worker_t *worker);
+      void try_scale();
 
       stomp::StompStats *stats() { return _stats; }
 
     protected:
     private:
       workers_t _workers;
+      unsigned int _last_id;
+
+      // autoscaling of stageAll workers, only the scaler thread
+      // touches _workers once it's running
+      pthread_t _scaler_id;
+      bool _scaling;
+      int _min_workers;
+      int _max_workers;
+      time_t _scale_interval;
+      int _scale_lag_high;
+      int _scale_lag_low;
+      int _scale_backlog_high;
+      int _scale_backlog_low;
+      int _scale_db_max;
+      int _scale_idle_rounds;
+      int _idle_rounds;
       stomp::StompStats *_stats;
+      ShardRouter *_router;
+      ResultPool *_pool;
+      DuplicateTable *_duplicates;
+      StationTable *_stations;
+      IdCache *_ids;
+      Preloader *_preloader;
+      IdSnapshot *_snapshot;
+      SingleFlight *_flights;
   }; // App
 
 /**************************************************************************
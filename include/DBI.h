@@ -24,9 +24,16 @@
 #ifndef APRSINJECT_DBI_H
 #define APRSINJECT_DBI_H
 
+#include <string>
+#include <utility>
+#include <vector>
+#include <map>
+
 #include <openframe/DBI.h>
 #include <aprs/APRS.h>
 
+#include "PacketRecord.h"
+
 namespace aprsinject {
 
 /**************************************************************************
@@ -34,6 +41,7 @@ namespace aprsinject {
  **************************************************************************/
 
 #define NULL_OPTIONPP(x, y) ( x->getString(y).length() > 0 ? mysqlpp::SQLTypeAdapter(x->getString(y)) : mysqlpp::SQLTypeAdapter(mysqlpp::null) )
+#define NULL_RECORDPP(h, x) ( h ? mysqlpp::SQLTypeAdapter(x) : mysqlpp::SQLTypeAdapter(mysqlpp::null) )
 #define NULL_VALID_OPTIONPP(v, s, x, y) (( x->getString(y).length() > 0 && v.is_valid(s, x->getString(y)) )  ? mysqlpp::SQLTypeAdapter(x->getString(y)) : mysqlpp::SQLTypeAdapter(mysqlpp::null) )
 
 
@@ -57,18 +65,33 @@ namespace aprsinject {
           const std::string &pass);
       virtual ~DBI();
 
+      static const size_t kMaxStationIds;
+
+      typedef std::pair<sqlid_t, std::string> idrow_t;
+      typedef std::vector<idrow_t> idrows_t;
+
+      // what position() may leave out while we're catching up
+      enum positionFlagEnum {
+        positionAll		= 0,
+        positionSkipExtras	= 1,	// last_phg, last_dfr, last_dfs, last_frequency, last_weather
+        positionSkipState	= 2	// last_position, station, last_position_meta
+      }; // positionFlagEnum
+
       void prepare_queries();
 
-      bool position(aprs::APRS *aprs);
-      bool message(aprs::APRS *aprs);
-      bool telemetry(aprs::APRS *aprs);
-      bool raw(aprs::APRS *aprs);
+      bool position(aprs::APRS *aprs, const PacketRecord &record, const int flags=positionAll);
+      bool message(aprs::APRS *aprs, const PacketRecord &record);
+      bool telemetry(aprs::APRS *aprs, const PacketRecord &record);
+      bool raw(aprs::APRS *aprs, const PacketRecord &record);
 
       bool getCallsignId(const std::string &, std::string &);
       bool getNameId(const std::string &, std::string &);
       bool getDestId(const std::string &, std::string &);
       bool getDigiId(const std::string &, std::string &);
       bool getMaidenheadId(const std::string &, std::string &);
+      bool getIds(const std::string &table, const std::string &column, const sqlid_t after, const sqlid_t before, const size_t limit, idrows_t &);
+      bool getIdsByName(const std::string &table, const std::string &column, const std::string &func, const std::vector<std::string> &names, idrows_t &);
+      bool insertNames(const std::string &table, const std::string &column, const std::string &func, const std::vector<std::string> &names);
       bool getPacketId(const std::string &);
       bool getPathId(const std::string &, std::string &);
       bool getStatusId(const std::string &, std::string &);
@@ -83,14 +106,22 @@ namespace aprsinject {
       bool insertDigi(const std::string &, std::string &);
       bool insertMaidenhead(const std::string &, std::string &);
       bool insertPath(const std::string &, const std::string &);
-      bool insertPacket(const std::string &, const std::string &);
+      bool insertPacket(const std::string &, const sqlid_t);
       bool insertPacket(const std::string &, std::string &);
       bool insertStatus(const std::string &, const std::string &);
 
       bool insertAndGetId(const std::string &, mysqlpp::Query &, std::string &);
 
     protected:
+      bool findStationId(const std::string &name, std::string &id);
+      void rememberStationId(const std::string &name, const std::string &id);
+
     private:
+      // station ids position() has already seen, so catching up on a
+      // station doesn't cost a lookup per packet
+      typedef std::map<std::string, std::string> stationIds_t;
+      typedef stationIds_t::iterator stationIds_itr;
+      stationIds_t _station_ids;
   }; // class DBI
 
 /**************************************************************************
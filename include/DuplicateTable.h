@@ -0,0 +1,106 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+
+#ifndef APRSINJECT_DUPLICATETABLE_H
+#define APRSINJECT_DUPLICATETABLE_H
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include <pthread.h>
+#include <time.h>
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** General Defines                                                      **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Structures                                                           **
+ **************************************************************************/
+
+  // Packets seen in the last window seconds, shared by every worker
+  // in the process, keyed by KeyHash of the packet.  Keys are split
+  // across stripes each with their own lock so workers rarely wait on
+  // each other.  Inside a stripe keys are also filed in one second
+  // buckets around a ring, a bucket is swept as the ring comes back
+  // around so expiry never has to walk the whole table.
+  class DuplicateTable {
+    public:
+      typedef unsigned long long key_t;
+
+      static const time_t kDefaultWindow;
+      static const size_t kDefaultStripes;
+
+      DuplicateTable(const time_t window=kDefaultWindow, const size_t num_stripes=kDefaultStripes);
+      virtual ~DuplicateTable();
+
+      // true if key was seen within the window, otherwise it's
+      // remembered as seen at timestamp
+      bool check(const key_t key, const time_t timestamp, const time_t now=time(NULL));
+      // remember without asking, for what another node already saw
+      void add(const key_t key, const time_t timestamp, const time_t now=time(NULL));
+
+      size_t size() const;
+      time_t window() const { return _window; }
+
+    protected:
+    private:
+      struct entry_t {
+        time_t timestamp;	// of the packet
+        time_t inserted;	// picks the bucket
+      }; // entry_t
+
+      typedef std::map<key_t, entry_t> seen_t;
+      typedef seen_t::iterator seen_itr;
+      typedef std::vector<key_t> bucket_t;
+      typedef std::vector<bucket_t> buckets_t;
+
+      struct stripe_t {
+        pthread_mutex_t lock;
+        seen_t seen;
+        buckets_t buckets;
+        time_t last_sweep;
+        char pad[64];
+      }; // stripe_t
+
+      stripe_t &stripe_for(const key_t key) { return _stripes[key % _num_stripes]; }
+      void sweep(stripe_t &stripe, const time_t now);
+      void insert(stripe_t &stripe, const key_t key, const time_t timestamp, const time_t now);
+
+      time_t _window;
+      size_t _num_stripes;
+      stripe_t *_stripes;
+  }; // class DuplicateTable
+
+/**************************************************************************
+ ** Macro's                                                              **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Proto types                                                          **
+ **************************************************************************/
+} // namespace aprsinject
+#endif
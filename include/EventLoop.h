@@ -0,0 +1,99 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+
+#ifndef APRSINJECT_EVENTLOOP_H
+#define APRSINJECT_EVENTLOOP_H
+
+#include <time.h>
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** General Defines                                                      **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Structures                                                           **
+ **************************************************************************/
+
+  // What a worker sleeps on between rounds.  An epoll set holding an
+  // eventfd other threads poke when they hand us work and a timerfd
+  // that ticks for the once a second housekeeping, stats, retries and
+  // acks.  Sources that can hand us a descriptor get added too.
+  //
+  // Producers only pay for the eventfd write while we're actually
+  // asleep.  The worker calls arm(), checks for work one last time,
+  // then wait()s; wake() checks the armed flag after publishing so
+  // one side always sees the other.
+  class EventLoop {
+    public:
+      static const time_t kTickInterval;
+
+      enum eventEnum {
+        eventNone		= 0x00,
+        eventWake		= 0x01,
+        eventTick		= 0x02,
+        eventReadable		= 0x04
+      }; // eventEnum
+
+      EventLoop(const time_t tick=kTickInterval);
+      virtual ~EventLoop();
+
+      bool add(const int fd);
+      bool remove(const int fd);
+
+      // any thread
+      void wake();
+
+      void arm() {
+        _armed = 1;
+        __sync_synchronize();
+      } // arm
+      void disarm() { _armed = 0; }
+      // -1 blocks until something happens, returns eventEnum bits
+      int wait(const int timeout_ms);
+
+      // seconds between the last wake() and us coming out of wait()
+      double wake_latency() const { return _wake_latency; }
+
+    protected:
+      static double now();
+
+    private:
+      int _epoll_fd;
+      int _wake_fd;
+      int _tick_fd;
+      volatile int _armed;
+      volatile double _signalled_at;
+      double _wake_latency;
+  }; // class EventLoop
+
+/**************************************************************************
+ ** Macro's                                                              **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Proto types                                                          **
+ **************************************************************************/
+} // namespace aprsinject
+#endif
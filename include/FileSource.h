@@ -0,0 +1,106 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+
+#ifndef APRSINJECT_FILESOURCE_H
+#define APRSINJECT_FILESOURCE_H
+
+#include <string>
+
+#include <time.h>
+
+#include "InputSource.h"
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** General Defines                                                      **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Structures                                                           **
+ **************************************************************************/
+
+  // Replays a capture of "<epoch> <packet>\n" lines, the same thing a
+  // broker frame carries, for backfills and benchmarks.  Plain files
+  // are mapped and handed out in place, .gz files are inflated a chunk
+  // at a time.  Speed is "realtime", "max" or a multiplier like "10x",
+  // paced off the first timestamp in the file.
+  class FileSource : public InputSource {
+    public:
+      static const size_t kDefaultBatch;
+      static const size_t kReadChunk;
+
+      FileSource(const std::string &path, const std::string &speed, const size_t batch=kDefaultBatch);
+      virtual ~FileSource();
+
+      bool open();
+      bool next(InputBatch &batch);
+      void release(InputBatch &batch);
+
+      bool is_eof() const { return _eof; }
+      std::string describe();
+      std::string last_error() { return _error; }
+
+      size_t lines() const { return _lines; }
+      // 0.0 means as fast as we can go
+      static double string_to_speed(const std::string &speed);
+
+    protected:
+      bool fill();
+      void close();
+      bool is_due(const time_t epoch);
+
+    private:
+      std::string _path;
+      std::string _speed_str;
+      double _speed;
+      size_t _batch;
+      bool _is_gzip;
+      bool _eof;
+      std::string _error;
+
+      int _fd;
+      void *_map;
+      size_t _map_size;
+      void *_gz;
+      std::string _buf;
+
+      // window we're currently handing out lines from
+      const char *_data;
+      size_t _length;
+      size_t _pos;
+
+      size_t _lines;
+      time_t _first_epoch;
+      double _started;
+  }; // class FileSource
+
+/**************************************************************************
+ ** Macro's                                                              **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Proto types                                                          **
+ **************************************************************************/
+} // namespace aprsinject
+#endif
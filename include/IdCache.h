@@ -0,0 +1,140 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+#ifndef APRSINJECT_IDCACHE_H
+#define APRSINJECT_IDCACHE_H
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "PacketRecord.h"
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** General Defines                                                      **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Structures                                                           **
+ **************************************************************************/
+
+  class IdSnapshot;
+
+  // Ids never change once the database hands them out, so every
+  // worker's Store looks here before going out to memcached.  Each
+  // namespace has its own capacity, striped like StationTable and
+  // evicted CLOCK style; a new entry only survives the hand coming
+  // around if it got looked up again in the meantime.
+  class IdCache {
+    public:
+      typedef uint64_t key_t;
+      typedef std::pair<key_t, sqlid_t> pair_t;
+      typedef std::vector<pair_t> pairs_t;
+
+      enum namespaceEnum {
+        nsCallsign		= 0,
+        nsName			= 1,
+        nsDest			= 2,
+        nsDigi			= 3,
+        nsMaidenhead		= 4,
+        nsMax			= 5
+      }; // namespaceEnum
+
+      static const size_t kDefaultCapacity;
+      static const size_t kDefaultStripes;
+
+      IdCache(const size_t num_stripes=kDefaultStripes);
+      virtual ~IdCache();
+
+      // throws away anything cached, only safe before it's shared,
+      // 0 turns the namespace off
+      IdCache &set_capacity(const namespaceEnum ns, const size_t capacity);
+      // misses fall back to what an earlier run wrote out, has to
+      // outlive the cache
+      IdCache &set_snapshot(const IdSnapshot *snapshot) {
+        _snapshot = snapshot;
+        return *this;
+      } // set_snapshot
+
+      bool find(const namespaceEnum ns, const key_t key, sqlid_t &ret_id);
+      void store(const namespaceEnum ns, const key_t key, const sqlid_t id);
+
+      size_t size(const namespaceEnum ns) const;
+      size_t capacity(const namespaceEnum ns) const { return _capacity[ns]; }
+      size_t memory(const namespaceEnum ns) const;
+      void dump(const namespaceEnum ns, pairs_t &ret) const;
+      // true for only one caller per interval, so stats about the
+      // cache as a whole go out once however many Stores share it
+      bool claim_report(const time_t interval);
+
+      static const char *namespace_to_string(const namespaceEnum ns);
+      // what both Store and Preloader key a name by
+      static key_t key_for(const namespaceEnum ns, const std::string &name);
+
+    protected:
+    private:
+      struct slot_t {
+        key_t key;
+        sqlid_t id;
+        bool referenced;
+      }; // slot_t
+
+      typedef std::map<key_t, size_t> index_t;
+      typedef index_t::iterator index_itr;
+      typedef std::vector<slot_t> slots_t;
+
+      struct stripe_t {
+        pthread_mutex_t lock;
+        index_t index;
+        slots_t slots;
+        size_t capacity;
+        size_t hand;
+        char pad[64];
+      }; // stripe_t
+
+      stripe_t &stripe_for(const namespaceEnum ns, const key_t key) {
+        return _stripes[ns][key % _num_stripes];
+      } // stripe_for
+
+      size_t _num_stripes;
+      size_t _capacity[nsMax];
+      stripe_t *_stripes[nsMax];
+      const IdSnapshot *_snapshot;
+      volatile time_t _last_report_at;
+  }; // class IdCache
+
+/**************************************************************************
+ ** Macro's                                                              **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Proto types                                                          **
+ **************************************************************************/
+} // namespace aprsinject
+#endif
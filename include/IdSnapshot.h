@@ -0,0 +1,102 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+#ifndef APRSINJECT_IDSNAPSHOT_H
+#define APRSINJECT_IDSNAPSHOT_H
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#include "IdCache.h"
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** General Defines                                                      **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Structures                                                           **
+ **************************************************************************/
+
+  // Read only view of an id dictionary written out by an earlier run,
+  // mapped straight from disk so a restart has every id it knew about
+  // without going to sql.  The file is a header followed by one array
+  // of key/id pairs per namespace sorted by key, written in host byte
+  // order so it's only good on the machine that wrote it.
+  class IdSnapshot {
+    public:
+      struct entry_t {
+        IdCache::key_t key;
+        sqlid_t id;
+      }; // entry_t
+
+      typedef std::vector<entry_t> entries_t;
+
+      static const uint32_t kMagic;
+      static const uint32_t kVersion;
+
+      IdSnapshot();
+      virtual ~IdSnapshot();
+
+      bool open(const std::string &path);
+      void close();
+      bool is_open() const { return _map != NULL; }
+      const std::string &last_error() const { return _error; }
+
+      bool find(const IdCache::namespaceEnum ns, const IdCache::key_t key, sqlid_t &ret_id) const;
+      size_t size(const IdCache::namespaceEnum ns) const { return _count[ns]; }
+      size_t size() const;
+      sqlid_t max_id(const IdCache::namespaceEnum ns) const { return _max_id[ns]; }
+      void copy(const IdCache::namespaceEnum ns, entries_t &ret) const;
+
+      // sorts entries and drops repeated keys, the first one wins
+      static bool write(const std::string &path, entries_t entries[IdCache::nsMax], std::string &error);
+
+    protected:
+    private:
+      struct header_t {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t count[IdCache::nsMax];
+        uint64_t max_id[IdCache::nsMax];
+      }; // header_t
+
+      void *_map;
+      size_t _map_size;
+      const entry_t *_entries[IdCache::nsMax];
+      size_t _count[IdCache::nsMax];
+      sqlid_t _max_id[IdCache::nsMax];
+      std::string _error;
+  }; // class IdSnapshot
+
+/**************************************************************************
+ ** Macro's                                                              **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Proto types                                                          **
+ **************************************************************************/
+} // namespace aprsinject
+#endif
@@ -0,0 +1,85 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+
+#ifndef APRSINJECT_INPUTSOURCE_H
+#define APRSINJECT_INPUTSOURCE_H
+
+#include <string>
+
+#include <openframe/openframe.h>
+
+#include "LineSlicer.h"
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** General Defines                                                      **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Structures                                                           **
+ **************************************************************************/
+
+  class InputSource_Exception : public openframe::OpenFrame_Exception {
+    public:
+      InputSource_Exception(const std::string message) throw() : openframe::OpenFrame_Exception(message) { };
+  }; // class InputSource_Exception
+
+  // One unit of input, a frame from the broker or a run of lines from
+  // a file.  The body is newline terminated "<epoch> <packet>" lines
+  // and stays valid until the batch is handed back to release().
+  struct InputBatch {
+    std::string id;		// what to ack, empty if the source doesn't
+    Slice body;
+    void *handle;		// belongs to the source
+
+    InputBatch() : handle(NULL) { }
+  }; // struct InputBatch
+
+  // Where a worker reads packets from.  open() is retried until it
+  // works, next() throws InputSource_Exception when the source is lost
+  // and has to be opened again.
+  class InputSource {
+    public:
+      virtual ~InputSource() { }
+
+      virtual bool open() = 0;
+      virtual bool next(InputBatch &batch) = 0;
+      virtual void release(InputBatch &batch) = 0;
+      virtual bool ack(const std::string &id) { return true; }
+
+      // nothing more will ever come out of next()
+      virtual bool is_eof() const { return false; }
+      virtual std::string describe() = 0;
+      virtual std::string last_error() = 0;
+  }; // class InputSource
+
+/**************************************************************************
+ ** Macro's                                                              **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Proto types                                                          **
+ **************************************************************************/
+} // namespace aprsinject
+#endif
@@ -0,0 +1,215 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+
+#ifndef APRSINJECT_KEYHASH_H
+#define APRSINJECT_KEYHASH_H
+
+#include <string>
+#include <cstring>
+
+#include <stdint.h>
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** General Defines                                                      **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Structures                                                           **
+ **************************************************************************/
+
+  // XXH64 for cache and dedup keys.  Pieces are fed in straight from
+  // wherever they live so a key never has to be built up as a string
+  // first, and with foldLower ASCII is lowercased eight bytes at a time
+  // on the way in so mixed case input hashes the same.  Lanes are read
+  // in host order, keys are only ever compared between our own x86
+  // boxes.
+  class KeyHash {
+    public:
+      enum foldEnum {
+        foldNone		= 0,
+        foldLower		= 1
+      }; // foldEnum
+
+      explicit KeyHash(const foldEnum fold=foldNone, const uint64_t seed=0) : _fold(fold) {
+        _v1 = seed + kPrime1 + kPrime2;
+        _v2 = seed + kPrime2;
+        _v3 = seed;
+        _v4 = seed - kPrime1;
+        _seed = seed;
+        _total = 0;
+        _used = 0;
+      } // KeyHash
+
+      KeyHash &update(const std::string &str) { return update(str.data(), str.length()); }
+      KeyHash &update(const char c) { return update(&c, 1); }
+      KeyHash &update(const char *data, size_t length) {
+        const unsigned char *p = reinterpret_cast<const unsigned char *>(data);
+        const unsigned char *end = p + length;
+        _total += length;
+
+        // top up what's left over from last time first
+        if (_used) {
+          size_t n = 32 - _used < length ? 32 - _used : length;
+          copy(_mem + _used, p, n);
+          _used += n;
+          p += n;
+          if (_used < 32) return *this;
+
+          stripe(_mem);
+          _used = 0;
+        } // if
+
+        unsigned char lanes[32];
+        for(; p + 32 <= end; p += 32) {
+          copy(lanes, p, 32);
+          stripe(lanes);
+        } // for
+
+        _used = end - p;
+        copy(_mem, p, _used);
+        return *this;
+      } // update
+
+      uint64_t digest() const {
+        uint64_t h;
+        if (_total >= 32) {
+          h = rotl(_v1, 1) + rotl(_v2, 7) + rotl(_v3, 12) + rotl(_v4, 18);
+          h = merge(h, _v1);
+          h = merge(h, _v2);
+          h = merge(h, _v3);
+          h = merge(h, _v4);
+        } // if
+        else
+          h = _seed + kPrime5;
+
+        h += _total;
+
+        const unsigned char *p = _mem;
+        const unsigned char *end = _mem + _used;
+        for(; p + 8 <= end; p += 8) {
+          h ^= round(0, read64(p));
+          h = rotl(h, 27) * kPrime1 + kPrime4;
+        } // for
+        if (p + 4 <= end) {
+          h ^= uint64_t(read32(p)) * kPrime1;
+          h = rotl(h, 23) * kPrime2 + kPrime3;
+          p += 4;
+        } // if
+        for(; p < end; p++) {
+          h ^= uint64_t(*p) * kPrime5;
+          h = rotl(h, 11) * kPrime1;
+        } // for
+
+        h ^= h >> 33;
+        h *= kPrime2;
+        h ^= h >> 29;
+        h *= kPrime3;
+        h ^= h >> 32;
+        return h;
+      } // digest
+
+      // 16 hex digits, what goes out to memcached as a key
+      std::string hex() const { return to_hex( digest() ); }
+      static std::string to_hex(uint64_t h) {
+        static const char digits[] = "0123456789abcdef";
+        char buf[16];
+        for(int i=15; i >= 0; i--, h >>= 4)
+          buf[i] = digits[h & 0xf];
+        return std::string(buf, 16);
+      } // to_hex
+
+      static uint64_t hash(const std::string &str, const foldEnum fold=foldNone) {
+        return KeyHash(fold).update(str).digest();
+      } // hash
+
+    private:
+      static const uint64_t kPrime1 = 11400714785074694791ULL;
+      static const uint64_t kPrime2 = 14029467366897019727ULL;
+      static const uint64_t kPrime3 = 1609587929392839161ULL;
+      static const uint64_t kPrime4 = 9650029242287828579ULL;
+      static const uint64_t kPrime5 = 2870177450012600261ULL;
+
+      static uint64_t rotl(const uint64_t x, const int r) { return (x << r) | (x >> (64 - r)); }
+      static uint64_t read64(const unsigned char *p) { uint64_t v; memcpy(&v, p, 8); return v; }
+      static uint32_t read32(const unsigned char *p) { uint32_t v; memcpy(&v, p, 4); return v; }
+
+      static uint64_t round(uint64_t acc, const uint64_t input) {
+        acc += input * kPrime2;
+        acc = rotl(acc, 31);
+        return acc * kPrime1;
+      } // round
+      static uint64_t merge(uint64_t acc, const uint64_t val) {
+        acc ^= round(0, val);
+        return acc * kPrime1 + kPrime4;
+      } // merge
+
+      // A-Z gets 0x20 added, everything else including UTF-8 is left
+      // alone, works on a whole word without looking at each byte
+      static uint64_t to_lower(const uint64_t x) {
+        const uint64_t high = 0x8080808080808080ULL;
+        uint64_t heptets = x & ~high;
+        uint64_t is_gt_Z = heptets + 0x2525252525252525ULL;
+        uint64_t is_ge_A = heptets + 0x3f3f3f3f3f3f3f3fULL;
+        uint64_t is_upper = ~x & (is_ge_A ^ is_gt_Z) & high;
+        return x | (is_upper >> 2);
+      } // to_lower
+
+      void copy(unsigned char *dst, const unsigned char *src, const size_t length) const {
+        memcpy(dst, src, length);
+        if (_fold == foldNone) return;
+
+        size_t i = 0;
+        for(; i + 8 <= length; i += 8) {
+          uint64_t v = to_lower( read64(dst + i) );
+          memcpy(dst + i, &v, 8);
+        } // for
+        for(; i < length; i++)
+          if (dst[i] >= 'A' && dst[i] <= 'Z') dst[i] += 0x20;
+      } // copy
+
+      void stripe(const unsigned char *p) {
+        _v1 = round(_v1, read64(p));
+        _v2 = round(_v2, read64(p + 8));
+        _v3 = round(_v3, read64(p + 16));
+        _v4 = round(_v4, read64(p + 24));
+      } // stripe
+
+      foldEnum _fold;
+      uint64_t _v1, _v2, _v3, _v4;
+      uint64_t _seed;
+      uint64_t _total;
+      unsigned char _mem[32];
+      size_t _used;
+  }; // class KeyHash
+
+/**************************************************************************
+ ** Macro's                                                              **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Proto types                                                          **
+ **************************************************************************/
+} // namespace aprsinject
+#endif
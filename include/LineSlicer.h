@@ -0,0 +1,120 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+#ifndef APRSINJECT_LINESLICER_H
+#define APRSINJECT_LINESLICER_H
+
+#include <string>
+#include <cstring>
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** General Defines                                                      **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Structures                                                           **
+ **************************************************************************/
+
+  // Non-owning view into a buffer, only valid for as long as the
+  // buffer it was sliced from.
+  class Slice {
+    public:
+      Slice() : _data(NULL), _length(0) { }
+      Slice(const char *data, const size_t length) : _data(data), _length(length) { }
+
+      const char *data() const { return _data; }
+      size_t length() const { return _length; }
+      bool empty() const { return _length == 0; }
+      std::string str() const { return std::string(_data, _length); }
+
+      // split on the first occurance of delim, the delimiter itself
+      // belongs to neither side
+      bool split(const char delim, Slice &head, Slice &tail) const {
+        const char *p = static_cast<const char *>( memchr(_data, delim, _length) );
+        if (p == NULL) return false;
+
+        head = Slice(_data, p - _data);
+        tail = Slice(p + 1, _length - (p - _data) - 1);
+        return true;
+      } // split
+
+      // same semantics as atol() without having to copy into a
+      // terminated string first
+      long to_long() const {
+        const char *p = _data;
+        const char *end = _data + _length;
+        while(p < end && (*p == ' ' || *p == '\t')) p++;
+
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+')) negative = (*p++ == '-');
+
+        long ret = 0;
+        for(; p < end && *p >= '0' && *p <= '9'; p++)
+          ret = (ret * 10) + (*p - '0');
+
+        return negative ? -ret : ret;
+      } // to_long
+
+    private:
+      const char *_data;
+      size_t _length;
+  }; // class Slice
+
+  // Walks a buffer once handing back each newline terminated line as
+  // a Slice, a trailing line without a newline is left unconsumed just
+  // like StreamParser::sfind() would.
+  class LineSlicer {
+    public:
+      LineSlicer(const char *data, const size_t length) :
+        _pos(data), _end(data + length) { }
+      LineSlicer(const std::string &buf) :
+        _pos(buf.data()), _end(buf.data() + buf.length()) { }
+
+      bool next(Slice &line) {
+        if (_pos >= _end) return false;
+
+        const char *p = static_cast<const char *>( memchr(_pos, '\n', _end - _pos) );
+        if (p == NULL) return false;
+
+        line = Slice(_pos, p - _pos);
+        _pos = p + 1;
+        return true;
+      } // next
+
+      Slice remaining() const { return Slice(_pos, _end - _pos); }
+
+    private:
+      const char *_pos;
+      const char *_end;
+  }; // class LineSlicer
+
+/**************************************************************************
+ ** Macro's                                                              **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Proto types                                                          **
+ **************************************************************************/
+} // namespace aprsinject
+#endif
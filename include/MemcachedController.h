@@ -26,7 +26,10 @@
 #ifndef APRSINJECT_MEMCACHEDCONTROLLER_H
 #define APRSINJECT_MEMCACHEDCONTROLLER_H
 
+#include <map>
 #include <set>
+#include <string>
+#include <vector>
 
 #include <netdb.h>
 #include <unistd.h>
@@ -66,15 +69,24 @@ class MemcachedController_Exception : public openframe::OpenFrame_Exception {
       enum memcachedReturnEnum {
         MEMCACHED_CONTROLLER_NOTFOUND,
         MEMCACHED_CONTROLLER_SUCCESS,
-        MEMCACHED_CONTROLLER_ERROR
+        MEMCACHED_CONTROLLER_ERROR,
+        MEMCACHED_CONTROLLER_EXISTS
       };
 
       // ### Members ###
       const memcachedReturnEnum get(const std::string &, const std::string &, std::string &);
+      const memcachedReturnEnum gets(const std::string &, const std::string &, std::string &, uint64_t &);
+      // one round trip for all of them, only what was found comes back
+      void mget(const std::string &, const std::vector<std::string> &, std::map<std::string, std::string> &);
       void put(const std::string &, const std::string &, const std::string &);
       void put(const std::string &, const std::string &, const std::string &, const time_t);
       void replace(const std::string &, const std::string &, const std::string &);
       void replace(const std::string &, const std::string &, const std::string &, const time_t);
+      // only stores when nobody else has, EXISTS means someone beat us
+      const memcachedReturnEnum add(const std::string &, const std::string &, const std::string &, const time_t);
+      // only stores when the item is unchanged since gets() handed out
+      // the cas value, EXISTS means it was and NOTFOUND it's gone
+      const memcachedReturnEnum cas(const std::string &, const std::string &, const std::string &, const time_t, const uint64_t);
       void remove(const std::string &, const std::string &);
       void flush(const time_t);
       void expire(const time_t expire) { _expire = expire; }
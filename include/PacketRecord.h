@@ -0,0 +1,108 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+
+#ifndef APRSINJECT_PACKETRECORD_H
+#define APRSINJECT_PACKETRECORD_H
+
+#include <string>
+
+#include <time.h>
+
+namespace aprs {
+  class APRS;
+} // namespace aprs
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** General Defines                                                      **
+ **************************************************************************/
+
+  typedef unsigned long long sqlid_t;
+
+/**************************************************************************
+ ** Structures                                                           **
+ **************************************************************************/
+
+  // Everything the inject path needs out of a parsed packet, pulled
+  // out of the APRS string map once right after parsing.  Ids start
+  // at zero and are filled in by Worker::preprocess, they go straight
+  // into queries as numbers from there on.
+  struct PacketRecord {
+    enum { kMaxDigis = 8 };
+
+    int type;
+    time_t timestamp;
+    bool is_object;
+    bool posdup;			// set by the position checks, not extract()
+
+    std::string packet_id;
+    std::string source;
+    std::string name;
+    std::string dest;
+    std::string target;
+    std::string locator;
+    std::string symbol_table;
+    std::string symbol_code;
+    std::string icon;
+
+    bool has_position;
+    double latitude;
+    double longitude;
+
+    bool has_course;
+    bool has_speed;
+    bool has_altitude;
+    int course;
+    int speed;
+    int altitude;
+
+    sqlid_t callsign_id;
+    sqlid_t name_id;
+    sqlid_t icon_id;
+    sqlid_t dest_id;
+    sqlid_t maidenhead_id;
+    sqlid_t target_id;
+
+    size_t num_digis;
+    std::string digis[kMaxDigis];
+    sqlid_t digi_ids[kMaxDigis];
+
+    PacketRecord() { clear(); }
+
+    void clear();
+    void extract(aprs::APRS *aprs);
+    bool has_name() const { return name.length() > 0; }
+
+    static sqlid_t to_id(const std::string &id);
+  }; // struct PacketRecord
+
+/**************************************************************************
+ ** Macro's                                                              **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Proto types                                                          **
+ **************************************************************************/
+} // namespace aprsinject
+#endif
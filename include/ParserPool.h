@@ -0,0 +1,102 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+#ifndef APRSINJECT_PARSERPOOL_H
+#define APRSINJECT_PARSERPOOL_H
+
+#include <vector>
+
+#include <pthread.h>
+#include <time.h>
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** General Defines                                                      **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Structures                                                           **
+ **************************************************************************/
+
+  class Result;
+
+  // Parses the lines of one frame across a handful of threads.  The
+  // caller hands over a batch and blocks until every job is done,
+  // jobs stay in the order they were given so the caller can walk
+  // them afterwards exactly as if it had parsed them itself.
+  class ParserPool {
+    public:
+      static const size_t kDefaultMinBatch;
+
+      struct job_t {
+        Result *result;
+        time_t timestamp;
+      }; // job_t
+
+      typedef std::vector<job_t> jobs_t;
+      typedef jobs_t::iterator jobs_itr;
+      typedef jobs_t::size_type jobs_st;
+
+      ParserPool(const size_t num_threads, const size_t min_batch=kDefaultMinBatch);
+      virtual ~ParserPool();
+
+      void start();
+      void stop();
+      void parse(jobs_t &jobs);
+
+      size_t min_batch() const { return _min_batch; }
+
+    protected:
+      static void *ParserThread(void *arg);
+      void run_jobs(jobs_t *jobs);
+
+    private:
+      typedef std::vector<pthread_t> threads_t;
+      typedef threads_t::size_type threads_st;
+
+      size_t _num_threads;
+      size_t _min_batch;
+      threads_t _threads;
+
+      pthread_mutex_t _lock;
+      pthread_cond_t _work_cond;
+      pthread_cond_t _done_cond;
+
+      jobs_t *_jobs;
+      unsigned int _generation;
+      size_t _active;
+      bool _done;
+
+      volatile size_t _next;
+      volatile size_t _remaining;
+  }; // class ParserPool
+
+/**************************************************************************
+ ** Macro's                                                              **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Proto types                                                          **
+ **************************************************************************/
+} // namespace aprsinject
+#endif
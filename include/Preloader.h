@@ -0,0 +1,118 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+#ifndef APRSINJECT_PRELOADER_H
+#define APRSINJECT_PRELOADER_H
+
+#include <string>
+
+#include <pthread.h>
+#include <time.h>
+
+#include <openframe/openframe.h>
+
+#include "IdCache.h"
+#include "IdSnapshot.h"
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** General Defines                                                      **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Structures                                                           **
+ **************************************************************************/
+
+  class DBI;
+
+  // Warms up the IdCache after a restart.  Streams each id table in
+  // chunks, newest rows first, on its own thread and database
+  // connection while the workers get going, stopping at the capacity
+  // of each namespace or where the mapped snapshot leaves off.  With
+  // a snapshot path it then writes the cache out every so often and
+  // once more on the way out for the next start to map.
+  class Preloader : public openframe::LogObject {
+    public:
+      static const size_t kDefaultChunk;
+      static const time_t kDefaultSnapshotInterval;
+
+      Preloader(const openframe::LogObject::thread_id_t thread_id,
+                IdCache *ids,
+                const std::string &host,
+                const std::string &user,
+                const std::string &pass,
+                const std::string &db,
+                const size_t chunk=kDefaultChunk);
+      virtual ~Preloader();
+
+      Preloader &set_preload(const bool preload) {
+        _preload = preload;
+        return *this;
+      } // set_preload
+      // mapped is what the cache already falls back to, may be NULL
+      Preloader &set_snapshot(const std::string &path, const time_t interval, const IdSnapshot *mapped) {
+        _snapshot_path = path;
+        _snapshot_interval = interval;
+        _mapped = mapped;
+        return *this;
+      } // set_snapshot
+
+      void start();
+      void stop();
+      bool is_done() const { return _done; }
+
+    protected:
+      static void *PreloadThread(void *arg);
+      void run();
+      void preload();
+      size_t preload(DBI *dbi, const IdCache::namespaceEnum ns);
+      void write_snapshot();
+
+    private:
+      IdCache *_ids;
+      std::string _host;
+      std::string _user;
+      std::string _pass;
+      std::string _db;
+      size_t _chunk;
+      bool _preload;
+      std::string _snapshot_path;
+      time_t _snapshot_interval;
+      const IdSnapshot *_mapped;
+      IdSnapshot *_written;
+
+      pthread_t _thread_id;
+      bool _started;
+      volatile bool _stop;
+      volatile bool _done;
+  }; // class Preloader
+
+/**************************************************************************
+ ** Macro's                                                              **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Proto types                                                          **
+ **************************************************************************/
+} // namespace aprsinject
+#endif
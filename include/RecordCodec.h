@@ -0,0 +1,186 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+
+#ifndef APRSINJECT_RECORDCODEC_H
+#define APRSINJECT_RECORDCODEC_H
+
+#include <string>
+
+#include <time.h>
+#include <stdint.h>
+
+#include "LineSlicer.h"
+#include "PacketRecord.h"
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** General Defines                                                      **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Structures                                                           **
+ **************************************************************************/
+
+  struct Icon;
+
+  // What we keep in memcached, the same fields whichever way they're
+  // written out.
+  struct DuplicateEntry {
+    std::string source;
+    time_t timestamp;
+    bool has_position;
+    double latitude;
+    double longitude;
+
+    DuplicateEntry() : timestamp(0), has_position(false), latitude(0.0), longitude(0.0) { }
+  }; // struct DuplicateEntry
+
+  struct PositionEntry {
+    std::string source;
+    double latitude;
+    double longitude;
+    time_t timestamp;
+    std::string comment;		// KeyHash of the comment
+
+    PositionEntry() : latitude(0.0), longitude(0.0), timestamp(0) { }
+  }; // struct PositionEntry
+
+  struct TrailEntry {
+    double latitude;
+    double longitude;
+    time_t timestamp;
+
+    TrailEntry() : latitude(0.0), longitude(0.0), timestamp(0) { }
+  }; // struct TrailEntry
+
+  struct LastpositionEntry {
+    std::string source;
+    time_t timestamp;
+    double latitude;
+    double longitude;
+    sqlid_t callsign_id;
+    sqlid_t name_id;
+    std::string packet_id;
+    std::string name;			// objects only
+    std::string path;
+    std::string course;			// the rest are empty if
+    std::string speed;			// the packet didn't have them
+    std::string altitude;
+    std::string symbol_table;
+    std::string symbol_code;
+    std::string overlay;
+    std::string phg_range;
+    std::string phg_directivity;
+    std::string icon;
+    std::string comment;
+
+    LastpositionEntry() : timestamp(0), latitude(0.0), longitude(0.0), callsign_id(0), name_id(0) { }
+  }; // struct LastpositionEntry
+
+  // Reads and writes memcached records either as the Vars text we've
+  // always used or as compact binary.  Binary starts with a byte Vars
+  // text never does, then a version and a record type.  Numbers are
+  // fixed width little endian, coordinates are microdegrees and
+  // strings carry a 16 bit length.
+  //
+  // Decoding takes either format so instances can be upgraded one at
+  // a time.  Fields are only ever appended to an entry and every list
+  // entry carries its length, so an older reader takes the fields it
+  // knows from a newer writer and skips the rest.
+  class RecordCodec {
+    public:
+      static const unsigned char kMagic;
+      static const unsigned char kVersion;
+
+      enum formatEnum {
+        formatText		= 0,
+        formatBinary		= 1
+      }; // formatEnum
+
+      enum typeEnum {
+        typeDuplicate		= 1,
+        typePosition		= 2,
+        typeIcon		= 3,
+        typeLastpositions	= 4,
+        typeTrail		= 5
+      }; // typeEnum
+
+      RecordCodec(const formatEnum format=formatText) : _format(format) { }
+
+      formatEnum format() const { return _format; }
+      static formatEnum string_to_format(const std::string &format);
+      static bool is_binary(const Slice &buf) { return buf.length() >= 3 && static_cast<unsigned char>(buf.data()[0]) == kMagic; }
+
+      std::string encode(const DuplicateEntry &entry) const;
+      std::string encode(const PositionEntry &entry) const;
+      std::string encode(const Icon &icon) const;
+      static bool decode(const std::string &buf, DuplicateEntry &entry);
+      static bool decode(const std::string &buf, PositionEntry &entry);
+      static bool decode(const std::string &buf, Icon &icon);
+
+      // lists are newest first, one entry per line in text
+      void begin_list(std::string &buf, const typeEnum type) const;
+      void append(std::string &buf, const LastpositionEntry &entry) const;
+      void append(std::string &buf, const TrailEntry &entry) const;
+      // copy an entry from another list, converting if it's the
+      // other format
+      void append(std::string &buf, const typeEnum type, const Slice &entry, const formatEnum format) const;
+
+    protected:
+    private:
+      formatEnum _format;
+  }; // class RecordCodec
+
+  // Walks a list written by either format.  Only the source and time
+  // are decoded to decide what to keep, entries that stay are copied
+  // over as they are.
+  class RecordListReader {
+    public:
+      RecordListReader(const std::string &buf, const RecordCodec::typeEnum type);
+
+      RecordCodec::formatEnum format() const { return _format; }
+      bool next(Slice &entry);
+
+      static bool peek(const Slice &entry, const RecordCodec::formatEnum format, const RecordCodec::typeEnum type,
+                       std::string &source, time_t &timestamp);
+      static bool decode(const Slice &entry, const RecordCodec::formatEnum format, LastpositionEntry &ret);
+      static bool decode(const Slice &entry, const RecordCodec::formatEnum format, TrailEntry &ret);
+
+    protected:
+    private:
+      RecordCodec::formatEnum _format;
+      LineSlicer _lines;
+      const char *_pos;
+      const char *_end;
+  }; // class RecordListReader
+
+/**************************************************************************
+ ** Macro's                                                              **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Proto types                                                          **
+ **************************************************************************/
+} // namespace aprsinject
+#endif
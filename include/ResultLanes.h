@@ -0,0 +1,106 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+
+#ifndef APRSINJECT_RESULTLANES_H
+#define APRSINJECT_RESULTLANES_H
+
+#include <string>
+#include <deque>
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** General Defines                                                      **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Structures                                                           **
+ **************************************************************************/
+
+  class Result;
+
+  // Stand-in for the old results deque that keeps one lane per kind
+  // of packet.  Messages always go first since someone is waiting on
+  // them, positions and everything else take turns after that so a
+  // flood of one can't starve the other.  Each lane keeps track of
+  // how long its results waited between being queued and handed out.
+  class ResultLanes {
+    public:
+      enum laneEnum {
+        laneMessage		= 0,
+        lanePosition		= 1,
+        laneBulk		= 2,
+        numLanes		= 3
+      }; // laneEnum
+
+      struct lane_stats_t {
+        unsigned int count;
+        double wait;
+        double wait_max;
+      }; // lane_stats_t
+
+      ResultLanes();
+      virtual ~ResultLanes();
+
+      void push_back(Result *result);
+      void push_front(Result *result);
+      Result *front();
+      void pop_front();
+
+      bool empty() const { return size() == 0; }
+      size_t size() const { return _size; }
+      size_t size(const laneEnum lane) const { return _lanes[lane].size(); }
+
+      const lane_stats_t &stats(const laneEnum lane) const { return _stats[lane]; }
+      void reset_stats();
+
+      static laneEnum lane_for(const Result *result);
+      static const char *lane_name(const laneEnum lane);
+
+    protected:
+      laneEnum next_lane();
+      static double now();
+
+    private:
+      struct entry_t {
+        Result *result;
+        double queued_at;
+      }; // entry_t
+
+      typedef std::deque<entry_t> lane_t;
+
+      lane_t _lanes[numLanes];
+      lane_stats_t _stats[numLanes];
+      size_t _size;
+      laneEnum _turn;
+  }; // class ResultLanes
+
+/**************************************************************************
+ ** Macro's                                                              **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Proto types                                                          **
+ **************************************************************************/
+} // namespace aprsinject
+#endif
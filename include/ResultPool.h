@@ -0,0 +1,83 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+#ifndef APRSINJECT_RESULTPOOL_H
+#define APRSINJECT_RESULTPOOL_H
+
+#include <string>
+
+#include <time.h>
+
+#include "ResultQueue.h"
+
+namespace aprs {
+  class APRS;
+} // namespace aprs
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** General Defines                                                      **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Structures                                                           **
+ **************************************************************************/
+
+  class Result;
+  class Slice;
+
+  // Free list of Results so their packet and error strings keep
+  // their buffers between packets.  The free list is a ResultQueue so
+  // a pool can be shared by the ingest stage, which takes Results, and
+  // the inject stage, which gives them back.
+  class ResultPool {
+    public:
+      static const size_t kDefaultSize;
+
+      ResultPool(const size_t size=kDefaultSize);
+      virtual ~ResultPool();
+
+      Result *acquire(const Slice &packet, const time_t now, bool &allocated);
+      void recycle(Result *result);
+
+      // override these to reuse parse objects, whatever create_aprs()
+      // hands out must still be safe to delete
+      virtual aprs::APRS *create_aprs(const std::string &packet, const time_t timestamp);
+      virtual void destroy_aprs(aprs::APRS *aprs);
+
+      size_t size() const { return _free.size(); }
+
+    protected:
+    private:
+      ResultQueue _free;
+  }; // class ResultPool
+
+/**************************************************************************
+ ** Macro's                                                              **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Proto types                                                          **
+ **************************************************************************/
+} // namespace aprsinject
+#endif
@@ -0,0 +1,89 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+#ifndef APRSINJECT_RESULTQUEUE_H
+#define APRSINJECT_RESULTQUEUE_H
+
+#include <cstddef>
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** General Defines                                                      **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Structures                                                           **
+ **************************************************************************/
+
+  class Result;
+  class EventLoop;
+
+  // Bounded multi-producer/multi-consumer queue used to hand parsed
+  // results from the ingest stage to the inject stage.  Each cell
+  // carries a sequence number so producers and consumers only ever
+  // contend on a single compare-and-swap, no locks are taken.
+  class ResultQueue {
+    public:
+      static const size_t kDefaultSize;
+
+      ResultQueue(const size_t size=kDefaultSize);
+      virtual ~ResultQueue();
+
+      bool push(Result *result);
+      bool pop(Result *&result);
+
+      size_t size() const;
+      size_t capacity() const { return _mask + 1; }
+      bool empty() const { return size() == 0; }
+
+      // consumer sleeping on loop gets woken on push
+      void set_notify(EventLoop *loop) { _notify = loop; }
+
+    protected:
+    private:
+      struct cell_t {
+        volatile size_t sequence;
+        Result *result;
+      }; // cell_t
+
+      cell_t *_buffer;
+      size_t _mask;
+      EventLoop *volatile _notify;
+
+      // keep the producer and consumer cursors on separate cache lines
+      char _pad0[64];
+      volatile size_t _enqueue_pos;
+      char _pad1[64];
+      volatile size_t _dequeue_pos;
+      char _pad2[64];
+  }; // class ResultQueue
+
+/**************************************************************************
+ ** Macro's                                                              **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Proto types                                                          **
+ **************************************************************************/
+} // namespace aprsinject
+#endif
@@ -0,0 +1,89 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+#ifndef APRSINJECT_RETRYWHEEL_H
+#define APRSINJECT_RETRYWHEEL_H
+
+#include <deque>
+#include <list>
+#include <vector>
+
+#include <time.h>
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** General Defines                                                      **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Structures                                                           **
+ **************************************************************************/
+
+  class Result;
+
+  // Hashed timer wheel with one second slots, deferred results are
+  // parked here until their backoff runs out instead of sleeping the
+  // worker.  Not thread safe, each worker owns its own.
+  class RetryWheel {
+    public:
+      static const size_t kDefaultSlots;
+
+      RetryWheel(const size_t slots=kDefaultSlots);
+      virtual ~RetryWheel();
+
+      typedef std::deque<Result *> results_t;
+
+      void schedule(Result *result, const time_t delay);
+      size_t expire(results_t &ready, const time_t now=time(NULL));
+      // everything still waiting, whether it's due or not
+      size_t expire_all(results_t &ready);
+      size_t size() const { return _size; }
+      bool empty() const { return _size == 0; }
+
+    protected:
+    private:
+      struct entry_t {
+        Result *result;
+        size_t rounds;
+      }; // entry_t
+
+      typedef std::list<entry_t> slot_t;
+      typedef slot_t::iterator slot_itr;
+      typedef std::vector<slot_t> slots_t;
+      typedef slots_t::size_type slots_st;
+
+      slots_t _slots;
+      slots_st _current;
+      time_t _last_tick;
+      size_t _size;
+  }; // class RetryWheel
+
+/**************************************************************************
+ ** Macro's                                                              **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Proto types                                                          **
+ **************************************************************************/
+} // namespace aprsinject
+#endif
@@ -0,0 +1,79 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+
+#ifndef APRSINJECT_SHARDROUTER_H
+#define APRSINJECT_SHARDROUTER_H
+
+#include <string>
+#include <vector>
+
+#include "ResultQueue.h"
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** General Defines                                                      **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Structures                                                           **
+ **************************************************************************/
+
+  class Result;
+
+  // One ResultQueue per inject thread, results are routed by the
+  // callsign they came from so a station always lands on the same
+  // inject thread.  Duplicate and position checks for a station then
+  // run in order on one thread and anything it keeps per station can
+  // stay local to that thread.
+  class ShardRouter {
+    public:
+      typedef std::vector<ResultQueue *> shards_t;
+      typedef shards_t::size_type shards_st;
+
+      ShardRouter(const size_t num_shards, const size_t queue_size=ResultQueue::kDefaultSize);
+      virtual ~ShardRouter();
+
+      bool push(Result *result);
+      size_t shard_for(const std::string &source) const;
+      ResultQueue *shard(const size_t i) { return _shards[i]; }
+
+      size_t num_shards() const { return _shards.size(); }
+      size_t size() const;
+
+      static unsigned int hash(const std::string &source);
+
+    protected:
+    private:
+      shards_t _shards;
+  }; // class ShardRouter
+
+/**************************************************************************
+ ** Macro's                                                              **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Proto types                                                          **
+ **************************************************************************/
+} // namespace aprsinject
+#endif
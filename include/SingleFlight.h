@@ -0,0 +1,107 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+
+#ifndef APRSINJECT_SINGLEFLIGHT_H
+#define APRSINJECT_SINGLEFLIGHT_H
+
+#include <map>
+#include <utility>
+
+#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "IdCache.h"
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** General Defines                                                      **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Structures                                                           **
+ **************************************************************************/
+
+  // A new station tends to show up on several workers at once, all of
+  // them missing the id cache and memcached together.  Whoever gets
+  // here first for a (namespace, key) leads and goes to the database,
+  // everyone else waits on it up to the configured time and then
+  // picks the id up from the cache the leader filled in.
+  class SingleFlight {
+    public:
+      enum flightEnum {
+        flightLeader		= 0,
+        flightJoined		= 1,
+        flightBusy		= 2
+      }; // flightEnum
+
+      static const time_t kDefaultWait;
+      static const size_t kDefaultStripes;
+
+      SingleFlight(const time_t wait_ms=kDefaultWait, const size_t num_stripes=kDefaultStripes);
+      virtual ~SingleFlight();
+
+      // flightLeader means the caller resolves it and has to land()
+      // after, flightJoined that the leader landed while we waited and
+      // flightBusy that it's still at it, with a 0 wait we never block
+      flightEnum join(const IdCache::namespaceEnum ns, const IdCache::key_t key);
+      void land(const IdCache::namespaceEnum ns, const IdCache::key_t key);
+
+      size_t size() const;
+      time_t wait() const { return _wait; }
+
+    protected:
+    private:
+      typedef std::pair<int, IdCache::key_t> flight_key_t;
+      // a flight is known by the sequence it took off with so a waiter
+      // can't mistake the next one on the same key for its own
+      typedef std::map<flight_key_t, uint64_t> flights_t;
+      typedef flights_t::iterator flights_itr;
+
+      struct stripe_t {
+        pthread_mutex_t lock;
+        pthread_cond_t landed;
+        flights_t flights;
+        uint64_t sequence;
+        char pad[64];
+      }; // stripe_t
+
+      stripe_t &stripe_for(const IdCache::key_t key) {
+        return _stripes[key % _num_stripes];
+      } // stripe_for
+
+      time_t _wait;
+      size_t _num_stripes;
+      stripe_t *_stripes;
+  }; // class SingleFlight
+
+/**************************************************************************
+ ** Macro's                                                              **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Proto types                                                          **
+ **************************************************************************/
+} // namespace aprsinject
+#endif
@@ -0,0 +1,104 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+
+#ifndef APRSINJECT_STATIONTABLE_H
+#define APRSINJECT_STATIONTABLE_H
+
+#include <map>
+
+#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** General Defines                                                      **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Structures                                                           **
+ **************************************************************************/
+
+  // Last position we accepted from each station, what the too soon,
+  // too fast and posdup checks compare against.  Shared by every
+  // worker, keyed by KeyHash of the callsign and striped the same way
+  // as DuplicateTable.  Stations we haven't heard from in expire
+  // seconds are dropped a stripe at a time.
+  class StationTable {
+    public:
+      typedef uint64_t key_t;
+
+      struct station_t {
+        double latitude;
+        double longitude;
+        time_t timestamp;
+        uint64_t comment;		// KeyHash of the comment
+      }; // station_t
+
+      static const time_t kDefaultExpire;
+      static const size_t kDefaultStripes;
+      static const time_t kSweepInterval;
+
+      StationTable(const time_t expire=kDefaultExpire, const size_t num_stripes=kDefaultStripes);
+      virtual ~StationTable();
+
+      bool find(const key_t key, station_t &ret);
+      void store(const key_t key, const station_t &station, const time_t now=time(NULL));
+
+      size_t size() const;
+
+    protected:
+    private:
+      struct entry_t {
+        station_t station;
+        time_t stored;
+      }; // entry_t
+
+      typedef std::map<key_t, entry_t> stations_t;
+      typedef stations_t::iterator stations_itr;
+
+      struct stripe_t {
+        pthread_mutex_t lock;
+        stations_t stations;
+        time_t last_sweep;
+        char pad[64];
+      }; // stripe_t
+
+      stripe_t &stripe_for(const key_t key) { return _stripes[key % _num_stripes]; }
+      void sweep(stripe_t &stripe, const time_t now);
+
+      time_t _expire;
+      size_t _num_stripes;
+      stripe_t *_stripes;
+  }; // class StationTable
+
+/**************************************************************************
+ ** Macro's                                                              **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Proto types                                                          **
+ **************************************************************************/
+} // namespace aprsinject
+#endif
@@ -0,0 +1,94 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+
+#ifndef APRSINJECT_STOMPSOURCE_H
+#define APRSINJECT_STOMPSOURCE_H
+
+#include <string>
+#include <deque>
+
+#include <time.h>
+
+#include "InputSource.h"
+
+namespace stomp {
+  class Stomp;
+  class StompFrame;
+} // namespace stomp
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** General Defines                                                      **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Structures                                                           **
+ **************************************************************************/
+
+  // Frames from a broker subscription.  The connection belongs to the
+  // worker which also sends on it, acks have to go out on the same
+  // connection the frames came in on.  The subscription's ack mode
+  // has to match how AckTracker acks, client acks everything up to
+  // the given message-id, client-individual only that one.  open()
+  // only counts as connected once the broker has sent a receipt for
+  // the SUBSCRIBE, messages that beat the receipt are held for next().
+  class StompSource : public InputSource {
+    public:
+      static const char *kAckClient;
+      static const char *kAckClientIndividual;
+      static const char *kSubscribeReceipt;
+      static const time_t kSubscribeTimeout;
+
+      StompSource(stomp::Stomp *stomp, const std::string &dest, const std::string &ack=kAckClientIndividual);
+      virtual ~StompSource();
+
+      bool open();
+      bool next(InputBatch &batch);
+      void release(InputBatch &batch);
+      bool ack(const std::string &id);
+
+      std::string describe();
+      std::string last_error();
+
+    protected:
+      bool is_usable(stomp::StompFrame *frame);
+      void clear_early();
+
+    private:
+      stomp::Stomp *_stomp;
+      std::string _dest;
+      std::string _ack;
+      std::string _error;
+      std::deque<stomp::StompFrame *> _early;
+  }; // class StompSource
+
+/**************************************************************************
+ ** Macro's                                                              **
+ **************************************************************************/
+
+/**************************************************************************
+ ** Proto types                                                          **
+ **************************************************************************/
+} // namespace aprsinject
+#endif
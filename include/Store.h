@@ -26,10 +26,18 @@
 #ifndef APRSINJECT_STORE_H
 #define APRSINJECT_STORE_H
 
+#include <map>
+#include <set>
+#include <string>
+
 #include <openframe/openframe.h>
 #include <openstats/StatsClient_Interface.h>
 
 #include "DBI.h"
+#include "IdCache.h"
+#include "PacketRecord.h"
+#include "RecordCodec.h"
+#include "SingleFlight.h"
 
 namespace aprsinject {
 
@@ -41,10 +49,23 @@ namespace aprsinject {
  ** Structures                                                           **
  **************************************************************************/
   class MemcachedController;
+
+  // Every distinct name a run of results is going to ask Store about,
+  // so they can be resolved together up front.
+  struct IdBatch {
+    typedef std::set<std::string> names_t;
+    names_t names[IdCache::nsMax];
+
+    void add(const IdCache::namespaceEnum ns, const std::string &name) {
+      if (name.length()) names[ns].insert(name);
+    } // add
+  }; // struct IdBatch
+
   class Store : public openframe::LogObject,
                 public openstats::StatsClient_Interface {
     public:
       static const time_t kDefaultReportInterval;
+      static const int kLastpositionsRetries;
 
       Store(const openframe::LogObject::thread_id_t thread_id,
             const std::string &host,
@@ -56,28 +77,50 @@ namespace aprsinject {
             const time_t report_interval=kDefaultReportInterval);
       virtual ~Store();
       Store &init();
+      // how records get written to memcached, either is always read
+      Store &set_record_format(const RecordCodec::formatEnum format) {
+        _codec = RecordCodec(format);
+        return *this;
+      } // set_record_format
+      const RecordCodec &codec() const { return _codec; }
+      // shared with the other workers, otherwise init() makes its own
+      Store &set_ids(IdCache *ids) {
+        _ids = ids;
+        return *this;
+      } // set_ids
+      // who's already off resolving a given id, shared like set_ids()
+      Store &set_flights(SingleFlight *flights) {
+        _flights = flights;
+        return *this;
+      } // set_flights
       void onDescribeStats();
       void onDestroyStats();
 
       void try_stats();
 
       bool getCallsignId(const std::string &source, std::string &ret_id);
+      bool getCallsignId(const std::string &source, sqlid_t &ret_id);
       bool getNameId(const std::string &source, std::string &ret_id);
+      bool getNameId(const std::string &source, sqlid_t &ret_id);
       bool getIconBySymbol(const std::string &symbol_table, const std::string &symbol_code, const int course, Icon &icon);
       bool getDestId(const std::string &dest, std::string &ret_id);
+      bool getDestId(const std::string &dest, sqlid_t &ret_id);
       bool getDigiId(const std::string &name, std::string &ret_id);
+      bool getDigiId(const std::string &name, sqlid_t &ret_id);
       bool getMaidenheadId(const std::string &locator, std::string &ret_id);
+      bool getMaidenheadId(const std::string &locator, sqlid_t &ret_id);
+      size_t resolveIds(const IdBatch &batch);
       bool getPacketId(const std::string &callsignId, std::string &ret_id);
-      bool setPacketId(const std::string &, const std::string &);
-      bool getDuplicateFromMemcached(const std::string &hash, std::string &buf);
-      bool setDuplicateInMemcached(const std::string &hash, const std::string &buf);
+      bool setPacketId(const sqlid_t, const std::string &);
+      bool isDuplicateInMemcached(const std::string &hash, const std::string &buf, const time_t expires);
       bool getPositionFromMemcached(const std::string &hash, std::string &buf);
       bool setPositionInMemcached(const std::string &hash, const std::string &buf);
       bool setLocatorSeenInMemcached(const std::string &locator);
       bool getLastpositionsFromMemcached(const std::string &locaator, std::string &ret);
-      bool setLastpositionsInMemcached(aprs::APRS *aprs);
+      bool getLastpositionsFromMemcached(const std::string &locaator, std::string &ret, uint64_t &cas);
+      bool setLastpositionsInMemcached(aprs::APRS *aprs, const PacketRecord &record);
       bool getPositionsFromMemcached(const std::string &source, std::string &ret);
-      bool setPositionsInMemcached(aprs::APRS *aprs);
+      bool setPositionsInMemcached(aprs::APRS *aprs, const PacketRecord &record);
       bool setStatus(const std::string &packetId, const std::string &body);
       bool setPath(const std::string &packetId, const std::string &body);
 
@@ -85,10 +128,10 @@ namespace aprsinject {
       std::string getDirectionByCourse(const int course);
 
       // injection members
-      bool injectPosition(aprs::APRS *aprs);
-      bool injectMessage(aprs::APRS *aprs);
-      bool injectTelemtry(aprs::APRS *aprs);
-      bool injectRaw(aprs::APRS *aprs);
+      bool injectPosition(aprs::APRS *aprs, const PacketRecord &record, const int flags=DBI::positionAll);
+      bool injectMessage(aprs::APRS *aprs, const PacketRecord &record);
+      bool injectTelemtry(aprs::APRS *aprs, const PacketRecord &record);
+      bool injectRaw(aprs::APRS *aprs, const PacketRecord &record);
 
     // ### Variables ###
 
@@ -110,12 +153,28 @@ namespace aprsinject {
 
       bool getIdFromMemcached(const std::string &area, const std::string &key, std::string &ret_id);
       bool setIdInMemcached(const std::string &area, const std::string &key, const std::string &id);
+      bool findId(const IdCache::namespaceEnum ns, const IdCache::key_t key, std::string &ret_id);
+      void storeId(const IdCache::namespaceEnum ns, const IdCache::key_t key, const std::string &id);
+
+      typedef bool (Store::*getId_f)(const std::string &, std::string &);
+      bool getIdOnce(const IdCache::namespaceEnum ns, const std::string &name, std::string &ret_id,
+                     getId_f fromMemcached, getId_f fromSql);
+      bool getCallsignIdFromSql(const std::string &source, std::string &ret_id);
+      bool getNameIdFromSql(const std::string &name, std::string &ret_id);
+      bool getDestIdFromSql(const std::string &dest, std::string &ret_id);
+      bool getDigiIdFromSql(const std::string &name, std::string &ret_id);
+      bool getMaidenheadIdFromSql(const std::string &locator, std::string &ret_id);
 
 
 
     private:
       DBI *_dbi;			// new Injection handler
       MemcachedController *_memcached;	// memcached controller instance
+      IdCache *_ids;			// ids in front of memcached
+      bool _own_ids;
+      SingleFlight *_flights;		// one resolver per missing id
+      bool _own_flights;
+      RecordCodec _codec;
       openframe::Stopwatch *_profile;
 
       // contructor vars
@@ -137,8 +196,23 @@ namespace aprsinject {
         unsigned int misses;
         unsigned int tries;
         unsigned int stored;
+        unsigned int conflicts;
       }; // memcache_stats_t
 
+      struct batch_stats_t {
+        unsigned int names;
+        unsigned int cached;
+        unsigned int memcached;
+        unsigned int sql;
+        unsigned int inserted;
+      }; // batch_stats_t
+
+      struct flight_stats_t {
+        unsigned int leaders;
+        unsigned int coalesced;
+        unsigned int busy;
+      }; // flight_stats_t
+
       struct sql_stats_t {
         unsigned int hits;
         unsigned int misses;
@@ -164,6 +238,9 @@ namespace aprsinject {
         memcache_stats_t cache_locatorseen;
         memcache_stats_t cache_lastpositions;
         memcache_stats_t cache_positions;
+        memcache_stats_t cache_ids[IdCache::nsMax];
+        batch_stats_t batch_ids;
+        flight_stats_t flight_ids[IdCache::nsMax];
         sql_stats_t sql_store;
         sql_stats_t sql_callsign;
         sql_stats_t sql_dest;
@@ -188,6 +265,12 @@ namespace aprsinject {
       obj_stats_t _stompstats;
 
       void init_stats(obj_stats_t &stats, const bool startup=false);
+
+      typedef std::map<IdCache::key_t, std::string> wanted_t;
+      typedef wanted_t::iterator wanted_itr;
+      std::string memcachedIdKey(const IdCache::namespaceEnum ns, const std::string &name);
+      void resolveIdsFromMemcached(const IdCache::namespaceEnum ns, wanted_t &wanted);
+      void resolveIdsFromSql(const IdCache::namespaceEnum ns, wanted_t &wanted);
 }; // Store
 
 /**************************************************************************
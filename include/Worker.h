@@ -4,12 +4,25 @@
 #include <string>
 #include <vector>
 #include <list>
+#include <map>
 
 #include <openframe/openframe.h>
 #include <openstats/openstats.h>
 #include <stomp/Stomp.h>
 #include <aprs/APRS.h>
 
+#include "LineSlicer.h"
+#include "AckTracker.h"
+#include "ResultPool.h"
+#include "PacketRecord.h"
+#include "ResultLanes.h"
+#include "DuplicateTable.h"
+#include "KeyHash.h"
+#include "RecordCodec.h"
+#include "StationTable.h"
+#include "IdCache.h"
+#include "SingleFlight.h"
+
 namespace aprsinject {
 /**************************************************************************
  ** General Defines                                                      **
@@ -22,6 +35,12 @@ namespace aprsinject {
   class MemcachedController;
   class DBI_Inject;
   class Store;
+  class ResultQueue;
+  class ShardRouter;
+  class RetryWheel;
+  class ParserPool;
+  class InputSource;
+  class EventLoop;
 
   class Work {
     public:
@@ -48,33 +67,91 @@ namespace aprsinject {
 
       Result(const std::string &packet, const time_t now) :
              _aprs(NULL),
+             _frame_ack(NULL),
+             _pool(NULL),
+             _ack(false),
+             _retries(0),
+             _parseTime(0.0), _packet(packet), _timestamp(now), _status(statusNone),
+             _dup_key(0), _dup_checked(false), _superseded(false) { }
+      Result(const Slice &packet, const time_t now) :
+             _aprs(NULL),
+             _frame_ack(NULL),
+             _pool(NULL),
              _ack(false),
-             _parseTime(0.0), _packet(packet), _timestamp(now), _status(statusNone) { }
+             _retries(0),
+             _parseTime(0.0), _packet(packet.data(), packet.length()), _timestamp(now), _status(statusNone),
+             _dup_key(0), _dup_checked(false), _superseded(false) { }
       virtual ~Result() {
         if (_aprs) delete _aprs;
+        // we're finished, let the frame we came from be acked
+        if (_frame_ack) _frame_ack->release();
       } // Result
 
       friend class Worker;
+      friend class ResultPool;
 
       time_t timestamp() const { return _timestamp; }
       double parseTime() const { return _parseTime; }
       std::string error() const { return _error; }
       std::string packet() const { return _packet; }
       bool ack() const { return _ack; }
+      unsigned int retries() const { return _retries; }
       statusEnum status() const { return _status; }
       bool is_status(statusEnum st) const { return _status == st; }
       aprs::APRS *aprs() const { return _aprs; }
+      const PacketRecord &record() const { return _record; }
+      bool parse(const time_t timestamp);
+      void set_frame_ack(FrameAck *frame_ack) {
+        frame_ack->retain();
+        _frame_ack = frame_ack;
+      } // set_frame_ack
+
+    protected:
+      // keep the string buffers, drop everything else
+      void reset(const Slice &packet, const time_t now) {
+        _packet.assign(packet.data(), packet.length());
+        _timestamp = now;
+        _status = statusNone;
+        _ack = false;
+        _retries = 0;
+        _parseTime = 0.0;
+        _dup_key = 0;
+        _dup_checked = false;
+        _superseded = false;
+      } // reset
+      void clear();
 
     private:
       aprs::APRS *_aprs;
+      PacketRecord _record;
+      FrameAck *_frame_ack;
+      ResultPool *_pool;
       bool _ack;
+      unsigned int _retries;
       double _parseTime;
       std::string _packet;
       std::string _error;
       time_t _timestamp;
       statusEnum _status;
+      // set when the raw line already went through the local
+      // duplicate table before being parsed
+      uint64_t _dup_key;
+      bool _dup_checked;
+      // a newer position for the same station is in the same catch
+      // up pass, that one gets to update the last known state
+      bool _superseded;
   };
 
+  // What a worker publishes about itself for App to scale on, only
+  // ever written by the worker and read by App so plain volatiles do.
+  struct WorkerLoad {
+    volatile double lag;
+    volatile size_t backlog;
+    volatile double db_time;
+
+    WorkerLoad() : lag(0.0), backlog(0), db_time(0.0) { }
+  }; // struct WorkerLoad
+
   class Worker_Exception : public openframe::OpenFrame_Exception {
     public:
       Worker_Exception(const std::string message) throw() : openframe::OpenFrame_Exception(message) { };
@@ -85,12 +162,33 @@ namespace aprsinject {
     public:
       // ### Constants ### //
       static const int kDefaultStompPrefetch;
+      static const size_t kDefaultInjectBatch;
+      static const size_t kDefaultBacklogHigh;
+      static const size_t kDefaultBacklogLow;
+      static const unsigned int kDefaultRetryMax;
+      static const time_t kDefaultRetryBackoff;
+      static const time_t kDefaultRetryBackoffMax;
+      static const time_t kDefaultCatchupAge;
+      static const time_t kDefaultCatchupRecover;
+      static const size_t kDefaultCatchupBatch;
+      static const int kMinIdleWait;
+      static const int kMaxIdleWait;
       static const time_t kDefaultStatsInterval;
       static const time_t kDefaultMemcachedExpire;
       static const char *kStompDestErrors;
       static const char *kStompDestRejects;
       static const char *kStompDestDuplicates;
       static const char *kStompDestNotifyMessages;
+      static const char *kStompDestDeadLetter;
+
+      // a worker can do everything itself or be split into an ingest
+      // stage that reads and parses frames and an inject stage that
+      // resolves ids and writes to the database, joined by a queue
+      enum stageEnum {
+        stageAll		= 0,
+        stageIngest		= 1,
+        stageInject		= 2
+      }; // stageEnum
 
       // ### Init ### //
       Worker(const openframe::LogObject::thread_id_t thread_id,
@@ -107,8 +205,13 @@ namespace aprsinject {
       virtual ~Worker();
       void init();
       bool run();
+      void wait();
       void try_stats();
       void try_locators();
+      void try_acks(const bool force=false);
+      void try_retries();
+      void drain();
+      void try_stations(const bool force=false);
 
       // ### Type Definitions ###
       typedef std::deque<Work *> work_t;
@@ -121,6 +224,14 @@ namespace aprsinject {
       typedef results_t::const_iterator results_citr;
       typedef results_t::size_type results_st;
 
+      // station state waiting to go out to memcached
+      typedef std::map<std::string, StationTable::station_t> stations_t;
+      typedef stations_t::iterator stations_itr;
+
+      // newest position written per station while catching up
+      typedef std::map<std::string, time_t> newest_t;
+      typedef newest_t::iterator newest_itr;
+
       typedef std::set<std::string> locators_t;
       typedef locators_t::iterator locators_itr;
       typedef locators_t::const_iterator locators_citr;
@@ -131,6 +242,93 @@ namespace aprsinject {
         _console = onoff;
         return *this;
       } // set_console
+      Worker &set_stage(const stageEnum stage, ResultQueue *queue) {
+        _stage = stage;
+        _queue = queue;
+        return *this;
+      } // set_stage
+      Worker &set_ack_mode(const AckTracker::ackModeEnum mode, const size_t batch) {
+        _ack_mode = mode;
+        _ack_batch = batch;
+        return *this;
+      } // set_ack_mode
+      Worker &set_backlog(const size_t high, const size_t low) {
+        _backlog_high = high;
+        _backlog_low = low;
+        return *this;
+      } // set_backlog
+      // ingest only, results go to the inject shard for their callsign
+      Worker &set_router(ShardRouter *router) {
+        _router = router;
+        return *this;
+      } // set_router
+      Worker &set_pool(ResultPool *pool) {
+        _pool = pool;
+        return *this;
+      } // set_pool
+      // remote also asks memcached so several instances can share
+      // what they've seen
+      Worker &set_duplicates(DuplicateTable *duplicates, const bool remote) {
+        _duplicates = duplicates;
+        _remote_duplicates = remote;
+        return *this;
+      } // set_duplicates
+      // drop local duplicates off the raw line before they're parsed
+      Worker &set_preparse_duplicates(const bool preparse) {
+        _preparse_duplicates = preparse;
+        return *this;
+      } // set_preparse_duplicates
+      // remote writes state through to memcached and asks it about
+      // stations we haven't heard from
+      Worker &set_ids(IdCache *ids) {
+        _ids = ids;
+        return *this;
+      } // set_ids
+      Worker &set_flights(SingleFlight *flights) {
+        _flights = flights;
+        return *this;
+      } // set_flights
+      Worker &set_stations(StationTable *stations, const bool remote) {
+        _stations = stations;
+        _remote_stations = remote;
+        return *this;
+      } // set_stations
+      // only go binary once nothing reading memcached needs text
+      Worker &set_record_format(const RecordCodec::formatEnum format) {
+        _record_format = format;
+        return *this;
+      } // set_record_format
+      // look up every id a handle pass needs together first
+      Worker &set_batch_ids(const bool batch_ids) {
+        _batch_ids = batch_ids;
+        return *this;
+      } // set_batch_ids
+      Worker &set_parsers(const size_t num_parsers) {
+        _num_parsers = num_parsers;
+        return *this;
+      } // set_parsers
+      Worker &set_load(WorkerLoad *load) {
+        _load = load;
+        return *this;
+      } // set_load
+      // 0 turns catch up mode off
+      Worker &set_catchup(const time_t age, const time_t recover) {
+        _catchup_age = age;
+        _catchup_recover = recover;
+        return *this;
+      } // set_catchup
+      // replay a capture instead of reading from the broker
+      Worker &set_input_file(const std::string &path, const std::string &speed) {
+        _input_file = path;
+        _input_speed = speed;
+        return *this;
+      } // set_input_file
+      Worker &set_retry_max(const unsigned int retry_max) {
+        _retry_max = retry_max;
+        return *this;
+      } // set_retry_max
+      stageEnum stage() const { return _stage; }
+      bool is_stage(const stageEnum stage) const { return _stage == stage; }
 
       // ### StatsClient Pure Virtuals ### //
       void onDescribeStats();
@@ -138,15 +336,31 @@ namespace aprsinject {
 
     protected:
       void try_stompstats();
-      Result *create_result(const std::string &body, const time_t timestamp);
+      Result *create_result(const Slice &body);
+      Result *finish_result(Result *result);
+      void recycle(Result *result);
       void print_result(Result *result);
       size_t handle_results();
+      bool dispatch_results();
+      void defer(Result *);
+      bool run_inject();
+      bool is_backlogged();
+      void try_catchup(const Result *result);
+      void resolve_ids(const std::vector<Result *> &results);
+      void publish_load();
+      void mark_superseded(const std::vector<Result *> &results);
+      int position_flags(const Result *result);
+      bool screen(Result *);
       bool handle(Result *);
       bool preprocess(Result *);
       bool inject(Result *);
       void process(Result *);
       bool checkForDuplicates(Result *);
+      bool checkForRemoteDuplicates(Result *, const std::string &key);
+      static bool duplicate_key(const Slice &packet, uint64_t &key);
+      void reject_duplicate(const Slice &packet, const Slice &info);
       bool checkForPositionErrors(Result *);
+      bool getRemoteStation(const std::string &source, StationTable::station_t &ret);
       void post_error(const char *dest, const std::string &packet, const Result *result);
 
     private:
@@ -161,17 +375,56 @@ namespace aprsinject {
       std::string _db_pass;
       std::string _db_database;
       bool _drop_defer;
+      std::string _input_file;
+      std::string _input_speed;
 
       openframe::Stopwatch *_profile;
 
       Store *_store;
       stomp::Stomp *_stomp;
+      InputSource *_input;
+      EventLoop *_loop;
+      int _idle_wait;
+      ResultQueue *_queue;
+      ShardRouter *_router;
+      stageEnum _stage;
+      AckTracker *_acks;
+      AckTracker::ackModeEnum _ack_mode;
+      size_t _ack_batch;
+      RetryWheel *_retries;
+      ParserPool *_parsers;
+      ResultPool *_pool;
+      bool _own_pool;
+      DuplicateTable *_duplicates;
+      bool _own_duplicates;
+      bool _remote_duplicates;
+      bool _preparse_duplicates;
+      RecordCodec::formatEnum _record_format;
+      StationTable *_stations;
+      bool _own_stations;
+      bool _remote_stations;
+      stations_t _pending_stations;
+      IdCache *_ids;
+      SingleFlight *_flights;
+      size_t _num_parsers;
+      bool _batch_ids;
+      unsigned int _retry_max;
+      size_t _backlog_high;
+      size_t _backlog_low;
+      bool _backlogged;
+      time_t _catchup_age;
+      time_t _catchup_recover;
+      bool _catchup;
+      double _lag;
+      WorkerLoad *_load;
+      newest_t _newest;
 
       work_t _work;
-      results_t _results;
+      ResultLanes _results;
       locators_t _locators;
 
       openframe::Intval *_locators_intval;
+      openframe::Intval *_stations_intval;
 
       bool _connected;
       bool _console;
@@ -199,6 +452,7 @@ namespace aprsinject {
       struct obj_stats_t {
         unsigned int connects;
         unsigned int disconnects;
+        unsigned int acks;
         unsigned int packets;
         unsigned int frames_in;
         unsigned int frames_out;
@@ -211,6 +465,24 @@ namespace aprsinject {
 
       struct obj_stompstats_t {
         aprs_stats_t aprs_stats;
+        size_t backlog_peak;
+        unsigned int backlog_pauses;
+        unsigned int retry_scheduled;
+        unsigned int retry_expired;
+        unsigned int retry_deadletter;
+        unsigned int catchup_switches;
+        unsigned int catchup_reduced;
+        unsigned int result_allocs;
+        unsigned int result_reuses;
+        unsigned int dup_local;
+        unsigned int dup_remote;
+        unsigned int dup_remote_checks;
+        unsigned int dup_preparse;
+        unsigned int station_local;
+        unsigned int station_remote;
+        unsigned int station_flushed;
+        unsigned int wakeups;
+        double wake_time;
         time_t report_interval;
         time_t last_report_at;
         time_t created_at;
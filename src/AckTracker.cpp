@@ -0,0 +1,108 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+#include <new>
+#include <string>
+#include <cassert>
+
+#include <time.h>
+
+#include <openframe/openframe.h>
+
+#include "AckTracker.h"
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** AckTracker Class                                                     **
+ **************************************************************************/
+  const size_t AckTracker::kDefaultBatch		= 32;
+  const time_t AckTracker::kDefaultInterval		= 1;
+
+  AckTracker::AckTracker(const ackModeEnum mode, const size_t batch, const time_t interval) :
+    _mode(mode), _batch(batch), _interval(interval) {
+    _last_collect_at = time(NULL);
+  } // AckTracker::AckTracker
+
+  AckTracker::~AckTracker() {
+    reset();
+  } // AckTracker::~AckTracker
+
+  void AckTracker::reset() {
+    // anything still here was never acked, let the broker
+    // redeliver it
+    while( !_frames.empty() ) {
+      _frames.front()->release();
+      _frames.pop_front();
+    } // while
+  } // AckTracker::reset
+
+  AckTracker::ackModeEnum AckTracker::string_to_mode(const std::string &mode) {
+    if (mode == "individual") return ackModeIndividual;
+    if (mode == "cumulative") return ackModeCumulative;
+    return ackModeFrame;
+  } // AckTracker::string_to_mode
+
+  FrameAck *AckTracker::track(const std::string &message_id) {
+    if (is_mode(ackModeFrame)) return NULL;
+
+    FrameAck *frame_ack;
+    try {
+      frame_ack = new FrameAck(message_id);
+    } // try
+    catch(std::bad_alloc &xa) {
+      assert(false);
+    } // catch
+
+    _frames.push_back(frame_ack);
+    return frame_ack;
+  } // AckTracker::track
+
+  size_t AckTracker::collect(acks_t &acks, const bool force) {
+    if (_frames.empty()) return 0;
+
+    time_t now = time(NULL);
+    bool is_due = force || _last_collect_at <= now - _interval;
+
+    // count how many frames at the front are committed, we never ack
+    // past a frame still in flight or a crash would lose it
+    frames_st num_done = 0;
+    for(frames_citr citr = _frames.begin(); citr != _frames.end() && (*citr)->is_done(); citr++)
+      num_done++;
+
+    if (!num_done || (!is_due && num_done < _batch)) return 0;
+
+    for(frames_st i=0; i < num_done; i++) {
+      FrameAck *frame_ack = _frames.front();
+      _frames.pop_front();
+
+      if (is_mode(ackModeIndividual) || i == num_done - 1)
+        acks.push_back(frame_ack->message_id());
+
+      frame_ack->release();
+    } // for
+
+    _last_collect_at = now;
+    return num_done;
+  } // AckTracker::collect
+
+} // namespace aprsinject
@@ -12,6 +12,15 @@
 
 #include "App.h"
 #include "Worker.h"
+#include "ResultQueue.h"
+#include "ShardRouter.h"
+#include "ResultPool.h"
+#include "DuplicateTable.h"
+#include "StationTable.h"
+#include "IdCache.h"
+#include "Preloader.h"
+#include "IdSnapshot.h"
+#include "SingleFlight.h"
 
 #include "aprsinject.h"
 
@@ -19,9 +28,26 @@ namespace aprsinject {
   using namespace openframe::loglevel;
 
   const char *App::kPidFile		= "aprsinject.pid";
+  const time_t App::kDefaultScaleInterval	= 30;
+  const int App::kDefaultScaleLagHigh		= 30;
+  const int App::kDefaultScaleLagLow		= 5;
+  const int App::kDefaultScaleBacklogHigh	= 1024;
+  const int App::kDefaultScaleBacklogLow	= 64;
+  const int App::kDefaultScaleIdleRounds	= 4;
 
   App::App(const std::string &prompt, const std::string &config, const bool console) :
     super(prompt, config, console) {
+    _router = NULL;
+    _pool = NULL;
+    _duplicates = NULL;
+    _stations = NULL;
+    _ids = NULL;
+    _preloader = NULL;
+    _snapshot = NULL;
+    _flights = NULL;
+    _last_id = 0;
+    _scaling = false;
+    _idle_rounds = 0;
   } // App::App
 
   App::~App() {
@@ -55,31 +81,243 @@ namespace aprsinject {
     _stats->set_elogger(elogger(), elog_name());
     _stats->start();
 
-    int num_workers = cfg->get_int("app.threads.worker", 0);
-    for(int i=0; i < num_workers; i++) {
-      openframe::ThreadMessage *tm = new openframe::ThreadMessage(i+1);
-      tm->var->push_void("app", app);
-      tm->var->push_uint("id", i+1);
-      pthread_t thread_id;
-      pthread_create(&thread_id, NULL, App::WorkerThread, tm);
-      LOG(LogNotice, << "*** WorkerThread " << thread_id << " Initialized" << std::endl);
-      _workers.push_back(thread_id);
+    // every worker in the process shares what it's seen
+    _duplicates = new DuplicateTable( cfg->get_int("app.threads.duplicates.window", DuplicateTable::kDefaultWindow),
+                                      cfg->get_int("app.threads.duplicates.stripes", DuplicateTable::kDefaultStripes) );
+    // last accepted position per station for the position checks
+    _stations = new StationTable( cfg->get_int("app.threads.stations.expire", StationTable::kDefaultExpire) );
+    // ids resolved by any worker, sized per namespace
+    _ids = new IdCache( cfg->get_int("app.threads.ids.stripes", IdCache::kDefaultStripes) );
+    for(int i=0; i < IdCache::nsMax; i++) {
+      IdCache::namespaceEnum ns = static_cast<IdCache::namespaceEnum>(i);
+      _ids->set_capacity(ns, cfg->get_int(std::string("app.threads.ids.capacity.") + IdCache::namespace_to_string(ns),
+                                          IdCache::kDefaultCapacity) );
     } // for
+    // workers missing the same id at once wait on whoever got there
+    // first, for up to wait ms, rather than all going to sql
+    _flights = new SingleFlight( cfg->get_int("app.threads.ids.flight.wait", SingleFlight::kDefaultWait),
+                                 cfg->get_int("app.threads.ids.flight.stripes", SingleFlight::kDefaultStripes) );
+
+    // whatever the last run knew is there as soon as it's mapped
+    std::string snapshot_path = cfg->get_string("app.threads.ids.snapshot.file", "");
+    if (!snapshot_path.empty()) {
+      _snapshot = new IdSnapshot();
+      if (_snapshot->open(snapshot_path)) {
+        LOG(LogNotice, << "*** Mapped " << _snapshot->size() << " ids from " << snapshot_path << std::endl);
+        _ids->set_snapshot(_snapshot);
+      } // if
+      else {
+        LOG(LogNotice, << "*** No id snapshot; " << _snapshot->last_error() << std::endl);
+        delete _snapshot;
+        _snapshot = NULL;
+      } // else
+    } // if
+
+    // a cold cache sends every worker to memcached and sql one id at
+    // a time, fill it in bulk alongside them instead
+    bool preload = cfg->get_int("app.threads.ids.preload", 1);
+    if (preload || !snapshot_path.empty()) {
+      _preloader = new Preloader(0, _ids,
+                                 cfg->get_string("app.threads.worker.sql.host", "localhost"),
+                                 cfg->get_string("app.threads.worker.sql.user"),
+                                 cfg->get_string("app.threads.worker.sql.pass"),
+                                 cfg->get_string("app.threads.worker.sql.database"),
+                                 cfg->get_int("app.threads.ids.preload.chunk", Preloader::kDefaultChunk) );
+      _preloader->set_elogger( elogger(), elog_name() );
+      _preloader->set_preload(preload);
+      _preloader->set_snapshot(snapshot_path,
+                               cfg->get_int("app.threads.ids.snapshot.interval", Preloader::kDefaultSnapshotInterval),
+                               _snapshot);
+      _preloader->start();
+    } // if
+
+    int num_workers = cfg->get_int("app.threads.worker", 0);
+    int num_ingest = cfg->get_int("app.threads.ingest", 0);
+    int num_inject = cfg->get_int("app.threads.inject", 0);
+
+    // every reader would replay the whole file, keep it to one
+    std::string input_file = cfg->get_string("app.threads.worker.input.file", "");
+    if (!input_file.empty()) {
+      if (num_ingest > 0 && num_inject > 0) {
+        num_workers = 0;
+        num_ingest = 1;
+      } // if
+      else
+        num_workers = 1;
+      LOG(LogNotice, << "*** Replaying " << input_file << " with a single reader" << std::endl);
+    } // if
+
+    for(int i=0; i < num_workers; i++)
+      start_worker(++_last_id, Worker::stageAll);
+
+    // workers come and go between min and max as load changes,
+    // leaving both alone keeps a fixed count
+    _min_workers = cfg->get_int("app.threads.worker.min", num_workers);
+    _max_workers = cfg->get_int("app.threads.worker.max", num_workers);
+    if (!input_file.empty()) _min_workers = _max_workers = num_workers;
+    _scale_interval = cfg->get_int("app.threads.scale.interval", kDefaultScaleInterval);
+    _scale_lag_high = cfg->get_int("app.threads.scale.lag.high", kDefaultScaleLagHigh);
+    _scale_lag_low = cfg->get_int("app.threads.scale.lag.low", kDefaultScaleLagLow);
+    _scale_backlog_high = cfg->get_int("app.threads.scale.backlog.high", kDefaultScaleBacklogHigh);
+    _scale_backlog_low = cfg->get_int("app.threads.scale.backlog.low", kDefaultScaleBacklogLow);
+    // past this many ms per inject the database is the bottleneck,
+    // more workers would only make it worse, 0 ignores it
+    _scale_db_max = cfg->get_int("app.threads.scale.db.max", 0);
+    _scale_idle_rounds = cfg->get_int("app.threads.scale.idle", kDefaultScaleIdleRounds);
+
+    // staged pipeline, ingest threads parse and hand results to inject
+    // threads through per callsign shards so slow sql doesn't stall
+    // reading and a station always lands on the same inject thread
+    if (num_ingest > 0 && num_inject > 0) {
+      _router = new ShardRouter(num_inject, cfg->get_int("app.threads.queue.size", ResultQueue::kDefaultSize) );
+      // inject hands spent results back to ingest through here
+      _pool = new ResultPool( cfg->get_int("app.threads.pool.size", ResultPool::kDefaultSize) );
+      LOG(LogNotice, << "*** Pipeline " << num_ingest << " ingest, "
+                     << num_inject << " inject, queue size "
+                     << _router->shard(0)->capacity() << " per shard" << std::endl);
+
+      for(int i=0; i < num_ingest; i++)
+        start_worker(++_last_id, Worker::stageIngest);
 
+      for(int i=0; i < num_inject; i++)
+        start_worker(++_last_id, Worker::stageInject, _router->shard(i));
+    } // if
+    else if (num_ingest > 0 || num_inject > 0)
+      LOG(LogWarn, << "*** Pipeline needs both app.threads.ingest and app.threads.inject, ignoring" << std::endl);
+
+    // last, from here on only the scaler touches _workers and _last_id
+    if (_max_workers > _min_workers && _max_workers > 0) {
+      LOG(LogNotice, << "*** Scaling workers between " << _min_workers
+                     << " and " << _max_workers << std::endl);
+      _scaling = true;
+      pthread_create(&_scaler_id, NULL, App::ScalerThread, this);
+    } // if
   } // App::onInitializeThreads
 
+  void App::start_worker(const unsigned int id, const int stage, ResultQueue *queue) {
+    worker_t *worker = new worker_t;
+    worker->id = id;
+    worker->stage = stage;
+    worker->stop = false;
+
+    openframe::ThreadMessage *tm = new openframe::ThreadMessage(id);
+    tm->var->push_void("app", app);
+    tm->var->push_void("worker", worker);
+    tm->var->push_void("queue", queue);
+    tm->var->push_void("router", stage == Worker::stageIngest ? _router : NULL);
+    tm->var->push_void("pool", stage == Worker::stageAll ? NULL : _pool);
+    tm->var->push_void("duplicates", _duplicates);
+    tm->var->push_void("stations", _stations);
+    tm->var->push_void("ids", _ids);
+    tm->var->push_void("flights", _flights);
+    tm->var->push_uint("id", id);
+    tm->var->push_uint("stage", stage);
+    pthread_create(&worker->thread_id, NULL, App::WorkerThread, tm);
+    LOG(LogNotice, << "*** WorkerThread " << worker->thread_id << " Initialized" << std::endl);
+    _workers.push_back(worker);
+  } // App::start_worker
+
+  void App::stop_worker(worker_t *worker) {
+    worker->stop = true;
+    LOG(LogNotice, << "*** Waiting for WorkerThread " << worker->thread_id << " to Deinitialize" << std::endl);
+    pthread_join(worker->thread_id, NULL);
+    delete worker;
+  } // App::stop_worker
+
+  void App::try_scale() {
+    int num_workers = 0;
+    double lag = 0.0;
+    size_t backlog = 0;
+    double db_time = 0.0;
+    for(workers_itr itr = _workers.begin(); itr != _workers.end(); itr++) {
+      if ((*itr)->stage != Worker::stageAll) continue;
+      lag += (*itr)->load.lag;
+      backlog += (*itr)->load.backlog;
+      db_time += (*itr)->load.db_time;
+      ++num_workers;
+    } // for
+
+    if (num_workers) {
+      lag /= num_workers;
+      backlog /= num_workers;
+      db_time /= num_workers;
+    } // if
+
+    bool is_behind = lag >= _scale_lag_high || backlog >= size_t(_scale_backlog_high);
+    bool is_idle = lag <= _scale_lag_low && backlog <= size_t(_scale_backlog_low);
+    bool is_db_bound = _scale_db_max && db_time * 1000.0 >= _scale_db_max;
+
+    if (num_workers < _min_workers || (is_behind && !is_db_bound && num_workers < _max_workers)) {
+      LOG(LogNotice, << "*** Scaling up from " << num_workers << " workers; lag " << lag
+                     << "s, backlog " << backlog << ", db " << db_time << "s" << std::endl);
+      start_worker(++_last_id, Worker::stageAll);
+      _idle_rounds = 0;
+      return;
+    } // if
+
+    if (is_behind && is_db_bound)
+      LOG(LogInfo, << "*** Behind but database is at " << db_time
+                   << "s per inject, not adding workers" << std::endl);
+
+    // only shrink after we've been quiet for a while so a lull
+    // between bursts doesn't have us flapping
+    _idle_rounds = is_idle ? _idle_rounds + 1 : 0;
+    if (_idle_rounds < _scale_idle_rounds || num_workers <= _min_workers) return;
+
+    // newest stageAll worker goes first
+    for(workers_t::reverse_iterator ritr = _workers.rbegin(); ritr != _workers.rend(); ritr++) {
+      if ((*ritr)->stage != Worker::stageAll) continue;
+
+      LOG(LogNotice, << "*** Scaling down from " << num_workers << " workers; lag " << lag
+                     << "s, backlog " << backlog << std::endl);
+      worker_t *worker = *ritr;
+      _workers.erase( --ritr.base() );
+      stop_worker(worker);
+      break;
+    } // for
+
+    _idle_rounds = 0;
+  } // App::try_scale
+
+  void *App::ScalerThread(void *arg) {
+    App *a = static_cast<App *>(arg);
+    time_t last_scale_at = time(NULL);
+
+    while( !a->is_done() ) {
+      sleep(1);
+      if (last_scale_at > time(NULL) - a->_scale_interval) continue;
+
+      a->try_scale();
+      last_scale_at = time(NULL);
+    } // while
+
+    return NULL;
+  } // App::ScalerThread
+
   void App::onDeinitializeSystem() { }
   void App::onDeinitializeCommands() { }
   void App::onDeinitializeDatabase() { }
   void App::onDeinitializeModules() { }
   void App::onDeinitializeThreads() {
+    // scaler first so nobody else is touching _workers
+    if (_scaling) pthread_join(_scaler_id, NULL);
+
     while(!_workers.empty()) {
-      pthread_t thread_id = _workers.front();
-      LOG(LogNotice, << "*** Waiting for WorkerThread " << thread_id << " to Deinitialize" << std::endl);
-      pthread_join(thread_id, NULL);
+      stop_worker( _workers.front() );
       _workers.pop_front();
     } // while
 
+    if (_router) delete _router;
+    if (_pool) delete _pool;
+    if (_duplicates) delete _duplicates;
+    if (_stations) delete _stations;
+    // still filling it or about to write it out, has to finish
+    // before it goes away
+    if (_preloader) delete _preloader;
+    if (_ids) delete _ids;
+    if (_snapshot) delete _snapshot;
+    if (_flights) delete _flights;
+
     _stats->stop();
     delete _stats;
   } // App::onDeinitializeThreads
@@ -109,7 +347,16 @@ namespace aprsinject {
   void *App::WorkerThread(void *arg) {
     openframe::ThreadMessage *tm = static_cast<openframe::ThreadMessage *>(arg);
     App *a = static_cast<App *>( tm->var->get_void("app") );
+    worker_t *slot = static_cast<worker_t *>( tm->var->get_void("worker") );
     unsigned int id = tm->var->get_uint("id");
+    ResultQueue *queue = static_cast<ResultQueue *>( tm->var->get_void("queue") );
+    ShardRouter *router = static_cast<ShardRouter *>( tm->var->get_void("router") );
+    ResultPool *pool = static_cast<ResultPool *>( tm->var->get_void("pool") );
+    DuplicateTable *duplicates = static_cast<DuplicateTable *>( tm->var->get_void("duplicates") );
+    StationTable *stations = static_cast<StationTable *>( tm->var->get_void("stations") );
+    IdCache *ids = static_cast<IdCache *>( tm->var->get_void("ids") );
+    SingleFlight *flights = static_cast<SingleFlight *>( tm->var->get_void("flights") );
+    Worker::stageEnum stage = static_cast<Worker::stageEnum>( tm->var->get_uint("stage") );
 
     Worker *worker = new Worker(id,
                                 a->cfg->get_string("app.threads.worker.stomp.hosts", "localhost:61613"),
@@ -131,14 +378,39 @@ namespace aprsinject {
     worker->replace_stats(a->stats(), s.str());
 
     worker->set_console( a->is_console() );
+    worker->set_load(&slot->load);
+    worker->set_stage(stage, queue);
+    if (router) worker->set_router(router);
+    if (pool) worker->set_pool(pool);
+    // memcached is only worth asking when other instances feed it too
+    worker->set_duplicates(duplicates, a->cfg->get_int("app.threads.worker.duplicates.remote", 0) );
+    worker->set_preparse_duplicates( a->cfg->get_int("app.threads.worker.duplicates.preparse", 1) );
+    worker->set_stations(stations, a->cfg->get_int("app.threads.worker.stations.remote", 0) );
+    worker->set_ids(ids);
+    worker->set_flights(flights);
+    worker->set_batch_ids( a->cfg->get_int("app.threads.worker.ids.batch", 1) );
+    worker->set_ack_mode( AckTracker::string_to_mode( a->cfg->get_string("app.threads.worker.stomp.ack.mode", "cumulative") ),
+                          a->cfg->get_int("app.threads.worker.stomp.ack.batch", AckTracker::kDefaultBatch) );
+    worker->set_parsers( a->cfg->get_int("app.threads.worker.parsers", 0) );
+    worker->set_record_format( RecordCodec::string_to_format( a->cfg->get_string("app.threads.worker.memcached.format", "text") ) );
+    worker->set_catchup( a->cfg->get_int("app.threads.worker.catchup.age", Worker::kDefaultCatchupAge),
+                         a->cfg->get_int("app.threads.worker.catchup.recover", Worker::kDefaultCatchupRecover) );
+    worker->set_retry_max( a->cfg->get_int("app.threads.worker.retry.max", Worker::kDefaultRetryMax) );
+    worker->set_input_file( a->cfg->get_string("app.threads.worker.input.file", ""),
+                            a->cfg->get_string("app.threads.worker.input.speed", "max") );
+    worker->set_backlog( a->cfg->get_int("app.threads.worker.backlog.high", Worker::kDefaultBacklogHigh),
+                         a->cfg->get_int("app.threads.worker.backlog.low", Worker::kDefaultBacklogLow) );
 
     worker->init();
 
-    while( !a->is_done() ) {
+    while( !a->is_done() && !slot->stop ) {
       bool did_work = worker->run();
-      if (!did_work) usleep(10000);
+      if (!did_work) worker->wait();
     } // while
 
+    // scaled down, finish what we were holding before we go
+    if (slot->stop) worker->drain();
+
     delete worker;
     delete tm;
 
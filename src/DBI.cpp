@@ -50,6 +50,8 @@ namespace aprsinject {
    ** DBI Class                                                     **
    **************************************************************************/
 
+  const size_t DBI::kMaxStationIds		= 100000;
+
   /******************************
    ** Constructor / Destructor **
    ******************************/
@@ -77,143 +79,150 @@ namespace aprsinject {
 
   } // DBI::prepare_queries
 
-  bool DBI::position(aprs::APRS *aprs) {
+  bool DBI::position(aprs::APRS *aprs, const PacketRecord &record, const int flags) {
     assert(aprs != NULL);
 
     Validator validator;
 
-    std::string packet_id = aprs->getString("aprs.packet.id");
-    std::string callsign_id = aprs->getString("aprs.packet.callsign.id");
-    std::string name_id = aprs->isString("aprs.packet.object.name.id") ? aprs->getString("aprs.packet.object.name.id") : "0";
-    std::string icon_id = aprs->getString("aprs.packet.icon.id");
-    std::string maidenhead_id = aprs->getString("aprs.packet.position.maidenhead.sql.id");
-    std::string station_name = aprs->isString("aprs.packet.object.name") ? aprs->getString("aprs.packet.object.name") : aprs->getString("aprs.packet.source");
+    const std::string &packet_id = record.packet_id;
+    const sqlid_t callsign_id = record.callsign_id;
+    const sqlid_t name_id = record.name_id;
+    const sqlid_t icon_id = record.icon_id;
+    const sqlid_t maidenhead_id = record.maidenhead_id;
+    const std::string &station_name = record.has_name() ? record.name : record.source;
+    bool skip_extras = flags & positionSkipExtras;
 
     bool ok = false;
     try {
       mysqlpp::Transaction trans(*_sqlpp);
       mysqlpp::Query query = _sqlpp->query();
 
-      //
-      // query for last_position
-      //
-      q("i_last_position")->execute(packet_id,
-                                    callsign_id,
-                                    name_id,
-                                    icon_id,
-                                    maidenhead_id,
-                                    aprs->latitude(),
-                                    aprs->longitude(),
-                                    aprs->timestamp()
-                                   );
+      // catching up on a station we already know, skip straight to
+      // its id and leave its last known state for a newer packet
+      std::string station_id;
+      bool skip_state = (flags & positionSkipState) && findStationId(station_name, station_id);
 
-      query = _sqlpp->query();
+      if (!skip_state) {
+        //
+        // query for last_position
+        //
+        q("i_last_position")->execute(packet_id,
+                                      callsign_id,
+                                      name_id,
+                                      icon_id,
+                                      maidenhead_id,
+                                      record.latitude,
+                                      record.longitude,
+                                      record.timestamp
+                                     );
 
-      query << "INSERT INTO station ("
-            << "station_type_id,"
-            << "name,"
-            << "callsign_id,"
-            << "name_id,"
-            << "last_position_packet_id,"
-            << "last_position_icon_id,"
-            << "last_position_symbol_table,"
-            << "last_position_symbol_code,"
-            << "last_position_maidenhead_id,"
-            << "last_position_latitude,"
-            << "last_position_longitude,"
-            << "last_position_create_ts,"
-            << "last_packet_id,"
-            << "last_packet_create_ts,"
-            << "create_ts"
-            << ") VALUES ("
-            << (aprs->isString("aprs.packet.object.name") ? "2" : "1")
-            << "," << mysqlpp::quote << station_name
-            << "," << callsign_id
-            << "," << name_id
-            << ",UUID_STRIP(" << mysqlpp::quote << packet_id << ")"
-            << "," << icon_id
-            << "," << mysqlpp::quote << aprs->getString("aprs.packet.symbol.table")
-            << "," << mysqlpp::quote << aprs->getString("aprs.packet.symbol.code")
-            << "," << maidenhead_id
-            << "," << aprs->latitude()
-            << "," << aprs->longitude()
-            << "," << aprs->timestamp()
-            << ",UUID_STRIP(" << mysqlpp::quote << packet_id << ")"
-            << "," << aprs->timestamp()
-            << "," << aprs->timestamp()
-            << ") ON DUPLICATE KEY UPDATE "
-            << "station_type_id=VALUES(station_type_id),"
-            << "callsign_id=VALUES(callsign_id),"
-            << "last_position_packet_id=VALUES(last_position_packet_id),"
-            << "last_position_icon_id=VALUES(last_position_icon_id),"
-            << "last_position_symbol_table=VALUES(last_position_symbol_table),"
-            << "last_position_symbol_code=VALUES(last_position_symbol_code),"
-            << "last_position_maidenhead_id=VALUES(last_position_maidenhead_id),"
-            << "last_position_latitude=VALUES(last_position_latitude),"
-            << "last_position_longitude=VALUES(last_position_longitude),"
-            << "last_position_create_ts=VALUES(last_position_create_ts),"
-            << "last_packet_id=VALUES(last_packet_id),"
-            << "last_packet_create_ts=VALUES(last_packet_create_ts)";
-      mysqlpp::SimpleResult res = query.execute();
+        query = _sqlpp->query();
 
-      std::string station_id;
-      if (res.rows() == 1) {
-        std::stringstream s;
-        s << res.insert_id();
-        station_id = s.str();
-      } // if
-      else {
-        ok = getStationId(station_name, station_id);
+        query << "INSERT INTO station ("
+              << "station_type_id,"
+              << "name,"
+              << "callsign_id,"
+              << "name_id,"
+              << "last_position_packet_id,"
+              << "last_position_icon_id,"
+              << "last_position_symbol_table,"
+              << "last_position_symbol_code,"
+              << "last_position_maidenhead_id,"
+              << "last_position_latitude,"
+              << "last_position_longitude,"
+              << "last_position_create_ts,"
+              << "last_packet_id,"
+              << "last_packet_create_ts,"
+              << "create_ts"
+              << ") VALUES ("
+              << (record.has_name() ? "2" : "1")
+              << "," << mysqlpp::quote << station_name
+              << "," << callsign_id
+              << "," << name_id
+              << ",UUID_STRIP(" << mysqlpp::quote << packet_id << ")"
+              << "," << icon_id
+              << "," << mysqlpp::quote << record.symbol_table
+              << "," << mysqlpp::quote << record.symbol_code
+              << "," << maidenhead_id
+              << "," << record.latitude
+              << "," << record.longitude
+              << "," << record.timestamp
+              << ",UUID_STRIP(" << mysqlpp::quote << packet_id << ")"
+              << "," << record.timestamp
+              << "," << record.timestamp
+              << ") ON DUPLICATE KEY UPDATE "
+              << "station_type_id=VALUES(station_type_id),"
+              << "callsign_id=VALUES(callsign_id),"
+              << "last_position_packet_id=VALUES(last_position_packet_id),"
+              << "last_position_icon_id=VALUES(last_position_icon_id),"
+              << "last_position_symbol_table=VALUES(last_position_symbol_table),"
+              << "last_position_symbol_code=VALUES(last_position_symbol_code),"
+              << "last_position_maidenhead_id=VALUES(last_position_maidenhead_id),"
+              << "last_position_latitude=VALUES(last_position_latitude),"
+              << "last_position_longitude=VALUES(last_position_longitude),"
+              << "last_position_create_ts=VALUES(last_position_create_ts),"
+              << "last_packet_id=VALUES(last_packet_id),"
+              << "last_packet_create_ts=VALUES(last_packet_create_ts)";
+        mysqlpp::SimpleResult res = query.execute();
+
+        if (res.rows() == 1) {
+          std::stringstream s;
+          s << res.insert_id();
+          station_id = s.str();
+        } // if
+        else {
+          ok = getStationId(station_name, station_id);
 
-        if (ok == false) {
-          TLOG(LogWarn, << "*** MySQL++ Error{Inject::position}: Could not get station id, rolling back!"
-                        << std::endl);
+          if (ok == false) {
+            TLOG(LogWarn, << "*** MySQL++ Error{Inject::position}: Could not get station id, rolling back!"
+                          << std::endl);
 
-          trans.rollback();
-          return ok;
-        } // if
-      } // else
+            trans.rollback();
+            return ok;
+          } // if
+        } // else
       
-      query = _sqlpp->query();
+        query = _sqlpp->query();
 
-      //
-      // query for last_position_meta
-      //
+        //
+        // query for last_position_meta
+        //
 //      mysqlpp::Null<std::string> dir = mysqlpp::quote << NULL_OPTIONPP(aprs, "aprs.packet.dirspd.direction");
-      query << "INSERT INTO last_position_meta (packet_id, callsign_id, name_id, dest_id, "
-            <<                                 "course, speed, altitude, symbol_table,"
-            <<                                 "symbol_code, overlay, `range`, type, weather, telemetry,"
-            <<                                 "position_type_id, mbits, create_ts) VALUES "
-            << "(UUID_STRIP(" << mysqlpp::quote << packet_id << ")"
-            << "," << callsign_id
-            << "," << name_id
-            << "," << aprs->getString("aprs.packet.destination.id")
-            << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:int", aprs, "aprs.packet.dirspd.direction")
-            << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:int", aprs, "aprs.packet.dirspd.speed")
-            << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:int", aprs, "aprs.packet.altitude")
-            << "," << mysqlpp::quote << aprs->getString("aprs.packet.symbol.table")
-            << "," << mysqlpp::quote << aprs->getString("aprs.packet.symbol.code")
-            << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "maxlen:1", aprs, "aprs.packet.symbol.overlay")
-            << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:float", aprs, "aprs.packet.rng")
-            << "," << mysqlpp::quote << aprs->getString("aprs.packet.object.type")
-            << "," << mysqlpp::quote << (aprs->isString("aprs.packet.weather") ? 'Y' : 'N')
-            << "," << mysqlpp::quote << (aprs->isString("aprs.packet.telemetry") ? 'Y' : 'N')
-            << "," << aprs->getString("aprs.packet.position.type.id")
-            << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "maxlen:3", aprs, "aprs.packet.mic_e.raw.mbits")
-            << "," << aprs->timestamp()
-            << ") ON DUPLICATE KEY UPDATE "
-            << "packet_id=VALUES(packet_id), callsign_id=VALUES(callsign_id), name_id=VALUES(name_id), dest_id=VALUES(dest_id),"
-            << "course=VALUES(course), speed=VALUES(speed), altitude=VALUES(altitude),"
-            << "symbol_table=VALUES(symbol_table), symbol_code=VALUES(symbol_code), overlay=VALUES(overlay),"
-            << "`range`=VALUES(`range`), type=VALUES(type), weather=VALUES(weather), telemetry=VALUES(telemetry), position_type_id=VALUES(position_type_id), mbits=VALUES(mbits),"
-            << "create_ts=VALUES(create_ts)";
-      query.execute();
-      query = _sqlpp->query();
+        query << "INSERT INTO last_position_meta (packet_id, callsign_id, name_id, dest_id, "
+              <<                                 "course, speed, altitude, symbol_table,"
+              <<                                 "symbol_code, overlay, `range`, type, weather, telemetry,"
+              <<                                 "position_type_id, mbits, create_ts) VALUES "
+              << "(UUID_STRIP(" << mysqlpp::quote << packet_id << ")"
+              << "," << callsign_id
+              << "," << name_id
+              << "," << record.dest_id
+              << "," << mysqlpp::quote << NULL_RECORDPP(record.has_course, record.course)
+              << "," << mysqlpp::quote << NULL_RECORDPP(record.has_speed, record.speed)
+              << "," << mysqlpp::quote << NULL_RECORDPP(record.has_altitude, record.altitude)
+              << "," << mysqlpp::quote << record.symbol_table
+              << "," << mysqlpp::quote << record.symbol_code
+              << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "maxlen:1", aprs, "aprs.packet.symbol.overlay")
+              << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:float", aprs, "aprs.packet.rng")
+              << "," << mysqlpp::quote << aprs->getString("aprs.packet.object.type")
+              << "," << mysqlpp::quote << (aprs->isString("aprs.packet.weather") ? 'Y' : 'N')
+              << "," << mysqlpp::quote << (aprs->isString("aprs.packet.telemetry") ? 'Y' : 'N')
+              << "," << aprs->getString("aprs.packet.position.type.id")
+              << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "maxlen:3", aprs, "aprs.packet.mic_e.raw.mbits")
+              << "," << record.timestamp
+              << ") ON DUPLICATE KEY UPDATE "
+              << "packet_id=VALUES(packet_id), callsign_id=VALUES(callsign_id), name_id=VALUES(name_id), dest_id=VALUES(dest_id),"
+              << "course=VALUES(course), speed=VALUES(speed), altitude=VALUES(altitude),"
+              << "symbol_table=VALUES(symbol_table), symbol_code=VALUES(symbol_code), overlay=VALUES(overlay),"
+              << "`range`=VALUES(`range`), type=VALUES(type), weather=VALUES(weather), telemetry=VALUES(telemetry), position_type_id=VALUES(position_type_id), mbits=VALUES(mbits),"
+              << "create_ts=VALUES(create_ts)";
+        query.execute();
+        query = _sqlpp->query();
+      } // if (!skip_state)
 
       //
       // query for last_phg
       //
-      if (aprs->isString("aprs.packet.phg.power")) {
+      if (!skip_extras && aprs->isString("aprs.packet.phg.power")) {
         query << "INSERT INTO last_phg (packet_id, callsign_id, name_id, power, haat, gain, `range`,"
               <<                       "direction, beacon, create_ts) VALUES"
               << "(UUID_STRIP(" << mysqlpp::quote << packet_id << ")"
@@ -225,7 +234,7 @@ namespace aprsinject {
               << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:float", aprs, "aprs.packet.phg.range")
               << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:int", aprs, "aprs.packet.phg.directivity")
               << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:int", aprs, "aprs.packet.phg.beacon")
-              << "," << aprs->timestamp()
+              << "," << record.timestamp
               << ") ON DUPLICATE KEY UPDATE "
               << "packet_id=VALUES(packet_id), callsign_id=VALUES(callsign_id), name_id=VALUES(name_id),"
               << "power=VALUES(power), haat=VALUES(haat), gain=VALUES(gain), `range`=VALUES(`range`),"
@@ -237,7 +246,7 @@ namespace aprsinject {
       //
       // query for last_dfr
       //
-      if (aprs->isString("aprs.packet.dfr.bearing")) {
+      if (!skip_extras && aprs->isString("aprs.packet.dfr.bearing")) {
         query << "INSERT INTO last_dfr (packet_id, callsign_id, name_id, bearing, hits, `range`,"
               <<                       "quality, create_ts) VALUES"
               << "(UUID_STRIP(" << mysqlpp::quote << packet_id << ")"
@@ -247,7 +256,7 @@ namespace aprsinject {
               << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:int", aprs, "aprs.packet.dfr.hits")
               << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:float", aprs, "aprs.packet.dfr.range")
               << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:int", aprs, "aprs.packet.dfr.quality")
-              << "," << aprs->timestamp()
+              << "," << record.timestamp
               << ") ON DUPLICATE KEY UPDATE "
               << "packet_id=VALUES(packet_id), callsign_id=VALUES(callsign_id), name_id=VALUES(name_id),"
               << "bearing=VALUES(bearing), hits=VALUES(hits), `range`=VALUES(`range`), quality=VALUES(quality),"
@@ -259,7 +268,7 @@ namespace aprsinject {
       //
       // query for last_dfs
       //
-      if (aprs->isString("aprs.packet.dfs.power")) {
+      if (!skip_extras && aprs->isString("aprs.packet.dfs.power")) {
         query << "INSERT INTO last_dfs (packet_id, callsign_id, name_id, power, haat, gain, `range`,"
               <<                       "direction, create_ts) VALUES"
               << "(UUID_STRIP(" << mysqlpp::quote << packet_id << ")"
@@ -270,7 +279,7 @@ namespace aprsinject {
               << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:float", aprs, "aprs.packet.phg.gain")
               << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:float", aprs, "aprs.packet.phg.range")
               << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:int", aprs, "aprs.packet.phg.directivity")
-              << "," << aprs->timestamp()
+              << "," << record.timestamp
               << ") ON DUPLICATE KEY UPDATE "
               << "packet_id=VALUES(packet_id), callsign_id=VALUES(callsign_id), name_id=VALUES(name_id),"
               << "power=VALUES(power), haat=VALUES(haat), gain=VALUES(gain), `range`=VALUES(`range`),"
@@ -282,7 +291,7 @@ namespace aprsinject {
       //
       // query for last_frequency
       //
-      if (aprs->isString("aprs.packet.afrs.frequency")) {
+      if (!skip_extras && aprs->isString("aprs.packet.afrs.frequency")) {
         query << "INSERT INTO last_frequency (packet_id, callsign_id, name_id, frequency, `range`,"
               <<                             "range_east, tone, afrs_type, receive, alternate, type, create_ts) VALUES"
               << "(UUID_STRIP(" << mysqlpp::quote << packet_id << ")"
@@ -296,7 +305,7 @@ namespace aprsinject {
               << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "maxlen:7", aprs, "aprs.packet.afrs.frequency.receive")
               << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "maxlen:7", aprs, "aprs.packet.afrs.frequency.alternate")
               << "," << mysqlpp::quote << aprs->getString("aprs.packet.object.type")
-              << "," << aprs->timestamp()
+              << "," << record.timestamp
               << ") ON DUPLICATE KEY UPDATE "
               << "packet_id=VALUES(packet_id), callsign_id=VALUES(callsign_id), name_id=VALUES(name_id),"
               << "frequency=VALUES(frequency), `range`=VALUES(`range`), range_east=VALUES(range_east), tone=VALUES(tone),"
@@ -306,8 +315,7 @@ namespace aprsinject {
         query = _sqlpp->query();
       } // if
 
-      if ( !aprs->isString("aprs.packet.position.posdup") &&
-           !aprs->is_object() ) {
+      if (!record.posdup && !record.is_object) {
         //
         // query for position
         //
@@ -326,15 +334,15 @@ namespace aprsinject {
               << ") VALUES ("
               << "UUID_STRIP(" << mysqlpp::quote << packet_id << ")"
               << "," << station_id
-              << "," << aprs->latitude()
-              << "," << aprs->longitude()
-              << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:int", aprs, "aprs.packet.dirspd.direction")
-              << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:int", aprs, "aprs.packet.dirspd.speed")
-              << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:int", aprs, "aprs.packet.altitude")
-              << "," << mysqlpp::quote << aprs->getString("aprs.packet.symbol.table")
-              << "," << mysqlpp::quote << aprs->getString("aprs.packet.symbol.code")
+              << "," << record.latitude
+              << "," << record.longitude
+              << "," << mysqlpp::quote << NULL_RECORDPP(record.has_course, record.course)
+              << "," << mysqlpp::quote << NULL_RECORDPP(record.has_speed, record.speed)
+              << "," << mysqlpp::quote << NULL_RECORDPP(record.has_altitude, record.altitude)
+              << "," << mysqlpp::quote << record.symbol_table
+              << "," << mysqlpp::quote << record.symbol_code
               << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:int", aprs, "aprs.packet.timestamp")
-              << "," << aprs->timestamp()
+              << "," << record.timestamp
               << ")";
         query.execute();
         query = _sqlpp->query();
@@ -342,37 +350,39 @@ namespace aprsinject {
 
       // Is the packet broadcasting weather information?
       if (aprs->getString("aprs.packet.weather").length() > 0) {
-        //
-        // query for last_weather
-        //
-        query << "INSERT INTO last_weather (packet_id, callsign_id, latitude, longitude,"
-              <<                           "wind_direction, wind_speed, wind_gust, temperature, rain_hour,"
-              <<                           "rain_calendar_day, rain_24hour_day, humidity, barometer,"
-              <<                           "luminosity, create_ts) VALUES "
-              << "(UUID_STRIP(" << mysqlpp::quote << packet_id << ")"
-              << "," << callsign_id
-              << "," << aprs->latitude()
-              << "," << aprs->longitude()
-              << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:int", aprs, "aprs.packet.weather.wind.direction")
-              << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:int", aprs, "aprs.packet.weather.wind.speed")
-              << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:int", aprs, "aprs.packet.weather.wind.gust")
-              << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:int", aprs, "aprs.packet.weather.temperature.celcius")
-              << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:float", aprs, "aprs.packet.weather.rain.hour")
-              << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:float", aprs, "aprs.packet.weather.rain.midnight")
-              << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:float", aprs, "aprs.packet.weather.rain.24hour")
-              << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:int|maxval:100", aprs, "aprs.packet.weather.humidity")
-              << "," << std::fixed << std::setprecision(2) << atof( aprs->getString("aprs.packet.weather.pressure").c_str() ) // FIXME: no need to divide
-              << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:int", aprs, "aprs.packet.weather.luminosity.wsm")
-              << "," << aprs->timestamp()
-              << ") ON DUPLICATE KEY UPDATE "
-              << "packet_id=VALUES(packet_id), callsign_id=VALUES(callsign_id),"
-              << "latitude=VALUES(latitude), longitude=VALUES(longitude),"
-              << "wind_direction=VALUES(wind_direction), wind_speed=VALUES(wind_speed), wind_gust=VALUES(wind_gust),"
-              << "temperature=VALUES(temperature), rain_hour=VALUES(rain_hour), rain_calendar_day=VALUES(rain_calendar_day),"
-              << "rain_24hour_day=VALUES(rain_24hour_day), humidity=VALUES(humidity), barometer=VALUES(barometer),"
-              << "luminosity=VALUES(luminosity), create_ts=VALUES(create_ts)";
-        query.execute();
-        query = _sqlpp->query();
+        if (!skip_extras) {
+          //
+          // query for last_weather
+          //
+          query << "INSERT INTO last_weather (packet_id, callsign_id, latitude, longitude,"
+                <<                           "wind_direction, wind_speed, wind_gust, temperature, rain_hour,"
+                <<                           "rain_calendar_day, rain_24hour_day, humidity, barometer,"
+                <<                           "luminosity, create_ts) VALUES "
+                << "(UUID_STRIP(" << mysqlpp::quote << packet_id << ")"
+                << "," << callsign_id
+                << "," << record.latitude
+                << "," << record.longitude
+                << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:int", aprs, "aprs.packet.weather.wind.direction")
+                << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:int", aprs, "aprs.packet.weather.wind.speed")
+                << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:int", aprs, "aprs.packet.weather.wind.gust")
+                << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:int", aprs, "aprs.packet.weather.temperature.celcius")
+                << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:float", aprs, "aprs.packet.weather.rain.hour")
+                << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:float", aprs, "aprs.packet.weather.rain.midnight")
+                << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:float", aprs, "aprs.packet.weather.rain.24hour")
+                << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:int|maxval:100", aprs, "aprs.packet.weather.humidity")
+                << "," << std::fixed << std::setprecision(2) << atof( aprs->getString("aprs.packet.weather.pressure").c_str() ) // FIXME: no need to divide
+                << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:int", aprs, "aprs.packet.weather.luminosity.wsm")
+                << "," << record.timestamp
+                << ") ON DUPLICATE KEY UPDATE "
+                << "packet_id=VALUES(packet_id), callsign_id=VALUES(callsign_id),"
+                << "latitude=VALUES(latitude), longitude=VALUES(longitude),"
+                << "wind_direction=VALUES(wind_direction), wind_speed=VALUES(wind_speed), wind_gust=VALUES(wind_gust),"
+                << "temperature=VALUES(temperature), rain_hour=VALUES(rain_hour), rain_calendar_day=VALUES(rain_calendar_day),"
+                << "rain_24hour_day=VALUES(rain_24hour_day), humidity=VALUES(humidity), barometer=VALUES(barometer),"
+                << "luminosity=VALUES(luminosity), create_ts=VALUES(create_ts)";
+          query.execute();
+          query = _sqlpp->query();
+        } // if (!skip_extras)
 
         query << "INSERT INTO weather (packet_id, callsign_id, wind_direction, wind_speed, wind_gust,"
               <<                      "temperature, rain_hour, rain_calendar_day, rain_24hour_day, humidity, barometer,"
@@ -389,7 +399,7 @@ namespace aprsinject {
               << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:int|maxval:100", aprs, "aprs.packet.weather.humidity")
               << "," << std::fixed << std::setprecision(2) << (atof(aprs->getString("aprs.packet.weather.pressure").c_str())) // FIXME: no need to divide
               << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:int", aprs, "aprs.packet.weather.luminosity.wsm")
-              << "," << aprs->timestamp()
+              << "," << record.timestamp
               << ")";
         query.execute();
         query = _sqlpp->query();
@@ -397,6 +407,9 @@ namespace aprsinject {
 
       trans.commit();
       ok = true;
+
+      // only once it's committed, a rolled back insert has no id
+      rememberStationId(station_name, station_id);
     } // try (transaction)
     catch(const mysqlpp::BadQuery &e) {
 
@@ -429,13 +442,13 @@ namespace aprsinject {
     return ok;
   } // DBI::position
 
-  bool DBI::message(aprs::APRS *aprs) {
+  bool DBI::message(aprs::APRS *aprs, const PacketRecord &record) {
     assert(aprs != NULL);
 
     Validator validator;
 
-    std::string packet_id = aprs->getString("aprs.packet.id");
-    std::string callsign_id = aprs->getString("aprs.packet.callsign.id");
+    const std::string &packet_id = record.packet_id;
+    const sqlid_t callsign_id = record.callsign_id;
 
     bool ok = false;
     try {
@@ -448,10 +461,10 @@ namespace aprsinject {
       query << "INSERT INTO message (packet_id, callsign_id, callsign_to_id, `body`, msgid, create_ts) VALUES "
             << "(UUID_STRIP(" << mysqlpp::quote << packet_id << ")"
             << "," << callsign_id
-            << "," << mysqlpp::quote << aprs->getString("aprs.packet.message.target.id")
+            << "," << record.target_id
             << "," << mysqlpp::quote << aprs->getString("aprs.packet.message.text")
             << "," << mysqlpp::quote << aprs->getString("aprs.packet.message.id")
-            << "," << aprs->timestamp()
+            << "," << record.timestamp
             << ")";
       query.execute();
       query = _sqlpp->query();
@@ -462,8 +475,8 @@ namespace aprsinject {
       query << "INSERT INTO last_message (packet_id, callsign_id, callsign_to_id, create_ts) VALUES "
             << "(UUID_STRIP(" << mysqlpp::quote << packet_id << ")"
             << "," << callsign_id
-            << "," << aprs->getString("aprs.packet.message.target.id")
-            << "," << aprs->timestamp()
+            << "," << record.target_id
+            << "," << record.timestamp
             << ") ON DUPLICATE KEY UPDATE "
             << "packet_id=VALUES(packet_id), callsign_id=VALUES(callsign_id), callsign_to_id=VALUES(callsign_to_id),"
             << "create_ts=VALUES(create_ts)";
@@ -476,7 +489,7 @@ namespace aprsinject {
       //
       openframe::StringTool::regexMatchListType regexList;
       if (openframe::StringTool::ereg("^((BLN[0-9A-Z]{1,6})|(NWS-[0-9A-Z]{1,5}))$",
-                                      aprs->getString("aprs.packet.message.target"),
+                                      record.target,
                                       regexList)) {
         query << "INSERT INTO last_bulletin (packet_id, callsign_id, addressee, text, id, create_ts) VALUES "
             << "(UUID_STRIP(" << mysqlpp::quote << packet_id << ")"
@@ -511,7 +524,7 @@ namespace aprsinject {
               << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:float", aprs, "aprs.packet.telemetry.a4.a")
               << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:float", aprs, "aprs.packet.telemetry.a4.b")
               << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:float", aprs, "aprs.packet.telemetry.a4.c")
-              << "," << aprs->timestamp()
+              << "," << record.timestamp
               << ") ON DUPLICATE KEY UPDATE "
               << "packet_id=VALUES(packet_id), callsign_id=VALUES(callsign_id), a_0=VALUES(a_0),"
               << "b_0=VALUES(b_0), c_0=VALUES(c_0), a_1=VALUES(a_1), b_1=VALUES(b_1), c_1=VALUES(c_1), a_2=VALUES(a_2), b_2=VALUES(b_2),"
@@ -539,7 +552,7 @@ namespace aprsinject {
               << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "maxlen:2", aprs, "aprs.packet.telemetry.digital5")
               << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "maxlen:2", aprs, "aprs.packet.telemetry.digital6")
               << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "maxlen:2", aprs, "aprs.packet.telemetry.digital7")
-              << "," << aprs->timestamp()
+              << "," << record.timestamp
               << ") ON DUPLICATE KEY UPDATE "
               << "packet_id=VALUES(packet_id), callsign_id=VALUES(callsign_id), a_0=VALUES(a_0),"
               << "a_1=VALUES(a_1), a_2=VALUES(a_2), a_3=VALUES(a_3), a_4=VALUES(a_4), d_0=VALUES(d_0), d_1=VALUES(d_1), d_2=VALUES(d_2),"
@@ -566,7 +579,7 @@ namespace aprsinject {
               << "," << mysqlpp::quote << NULL_OPTIONPP(aprs, "aprs.packet.telemetry.digital5")
               << "," << mysqlpp::quote << NULL_OPTIONPP(aprs, "aprs.packet.telemetry.digital6")
               << "," << mysqlpp::quote << NULL_OPTIONPP(aprs, "aprs.packet.telemetry.digital7")
-              << "," << aprs->timestamp()
+              << "," << record.timestamp
               << ") ON DUPLICATE KEY UPDATE "
               << "packet_id=VALUES(packet_id), callsign_id=VALUES(callsign_id), a_0=VALUES(a_0),"
               << "a_1=VALUES(a_1), a_2=VALUES(a_2), a_3=VALUES(a_3), a_4=VALUES(a_4), d_0=VALUES(d_0), d_1=VALUES(d_1), d_2=VALUES(d_2),"
@@ -581,7 +594,7 @@ namespace aprsinject {
               << "," << callsign_id
               << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "maxlen:8|minlen:8|chrng:48-49", aprs, "aprs.packet.telemetry.bitsense")
               << "," << mysqlpp::quote << aprs->getString("aprs.packet.telemetry.project")
-              << "," << aprs->timestamp()
+              << "," << record.timestamp
               << ") ON DUPLICATE KEY UPDATE "
               << "packet_id=VALUES(packet_id), callsign_id=VALUES(callsign_id), bitsense=VALUES(bitsense),"
               << "project_title=VALUES(project_title), create_ts=VALUES(create_ts)";
@@ -624,11 +637,11 @@ namespace aprsinject {
     return ok;
   } // DBI::message
 
-  bool DBI::raw(aprs::APRS *aprs) {
+  bool DBI::raw(aprs::APRS *aprs, const PacketRecord &record) {
     assert(aprs != NULL);
 
-    std::string packet_id = aprs->getString("aprs.packet.id");
-    std::string callsign_id = aprs->getString("aprs.packet.callsign.id");
+    const std::string &packet_id = record.packet_id;
+    const sqlid_t callsign_id = record.callsign_id;
 
     bool ok = false;
     try {
@@ -659,15 +672,15 @@ namespace aprsinject {
             <<                       "digi7_id, create_ts) VALUES "
             << "(UUID_STRIP(" << mysqlpp::quote << packet_id << ")"
             << "," << callsign_id
-            << "," << aprs->getString("aprs.packet.destination.id")
-            << "," << aprs->getString("aprs.packet.path1.id")
-            << "," << aprs->getString("aprs.packet.path2.id")
-            << "," << aprs->getString("aprs.packet.path3.id")
-            << "," << aprs->getString("aprs.packet.path4.id")
-            << "," << aprs->getString("aprs.packet.path5.id")
-            << "," << aprs->getString("aprs.packet.path6.id")
-            << "," << aprs->getString("aprs.packet.path7.id")
-            << "," << aprs->getString("aprs.packet.path8.id")
+            << "," << record.dest_id
+            << "," << record.digi_ids[0]
+            << "," << record.digi_ids[1]
+            << "," << record.digi_ids[2]
+            << "," << record.digi_ids[3]
+            << "," << record.digi_ids[4]
+            << "," << record.digi_ids[5]
+            << "," << record.digi_ids[6]
+            << "," << record.digi_ids[7]
             << ", UNIX_TIMESTAMP()"
             << ") ON DUPLICATE KEY UPDATE "
             << "packet_id=VALUES(packet_id), callsign_id=VALUES(callsign_id), dest_id=VALUES(dest_id),"
@@ -685,7 +698,7 @@ namespace aprsinject {
             << "(UUID_STRIP(" << mysqlpp::quote << packet_id << ")"
             << "," << callsign_id
             << "," << mysqlpp::quote << aprs->getString("aprs.packet.raw")
-            << "," << aprs->timestamp()
+            << "," << record.timestamp
             << ")";
       query.execute();
       query = _sqlpp->query();
@@ -698,16 +711,16 @@ namespace aprsinject {
             <<                       "digi5_id, digi6_id, digi7_id, create_ts) VALUES "
             << "(UUID_STRIP(" << mysqlpp::quote << packet_id << ")"
             << "," << callsign_id
-            << "," << aprs->getString("aprs.packet.destination.id")
-            << "," << aprs->getString("aprs.packet.path1.id")
-            << "," << aprs->getString("aprs.packet.path2.id")
-            << "," << aprs->getString("aprs.packet.path3.id")
-            << "," << aprs->getString("aprs.packet.path4.id")
-            << "," << aprs->getString("aprs.packet.path5.id")
-            << "," << aprs->getString("aprs.packet.path6.id")
-            << "," << aprs->getString("aprs.packet.path7.id")
-            << "," << aprs->getString("aprs.packet.path8.id")
-            << "," << aprs->timestamp()
+            << "," << record.dest_id
+            << "," << record.digi_ids[0]
+            << "," << record.digi_ids[1]
+            << "," << record.digi_ids[2]
+            << "," << record.digi_ids[3]
+            << "," << record.digi_ids[4]
+            << "," << record.digi_ids[5]
+            << "," << record.digi_ids[6]
+            << "," << record.digi_ids[7]
+            << "," << record.timestamp
             << ")";
       query.execute();
       query = _sqlpp->query();
@@ -744,13 +757,13 @@ namespace aprsinject {
     return ok;
   } // DBI::raw
 
-  bool DBI::telemetry(aprs::APRS *aprs) {
+  bool DBI::telemetry(aprs::APRS *aprs, const PacketRecord &record) {
     assert(aprs != NULL);
 
     Validator validator;
 
-    std::string packet_id = aprs->getString("aprs.packet.id");
-    std::string callsign_id = aprs->getString("aprs.packet.callsign.id");
+    const std::string &packet_id = record.packet_id;
+    const sqlid_t callsign_id = record.callsign_id;
 
     bool ok = false;
     try {
@@ -771,7 +784,7 @@ namespace aprsinject {
             << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:float", aprs, "aprs.packet.telemetry.analog3")
             << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:float", aprs, "aprs.packet.telemetry.analog4")
             << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "maxlen:8", aprs, "aprs.packet.telemetry.digital")
-            << "," << aprs->timestamp()
+            << "," << record.timestamp
             << ") ON DUPLICATE KEY UPDATE "
             << "packet_id=VALUES(packet_id), callsign_id=VALUES(callsign_id),"
             << "sequence=VALUES(sequence), analog_0=VALUES(analog_0), analog_1=VALUES(analog_1),"
@@ -794,7 +807,7 @@ namespace aprsinject {
             << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:float", aprs, "aprs.packet.telemetry.analog3")
             << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "is:float", aprs, "aprs.packet.telemetry.analog4")
             << "," << mysqlpp::quote << NULL_VALID_OPTIONPP(validator, "maxlen:8", aprs, "aprs.packet.telemetry.digital")
-            << "," << aprs->timestamp()
+            << "," << record.timestamp
             << ")";
       query.execute();
       query = _sqlpp->query();
@@ -1039,6 +1052,25 @@ namespace aprsinject {
     return (numRows > 0) ? true : false;
   } // DBI::getStationId
 
+  bool DBI::findStationId(const std::string &name, std::string &id) {
+    stationIds_itr itr = _station_ids.find(name);
+    if (itr != _station_ids.end()) {
+      id = itr->second;
+      return true;
+    } // if
+
+    bool ok = getStationId(name, id);
+    if (ok) rememberStationId(name, id);
+    return ok;
+  } // DBI::findStationId
+
+  void DBI::rememberStationId(const std::string &name, const std::string &id) {
+    if (id.empty()) return;
+    // start over rather than let a long catch up grow it forever
+    if (_station_ids.size() >= kMaxStationIds) _station_ids.clear();
+    _station_ids[name] = id;
+  } // DBI::rememberStationId
+
   bool DBI::getDigiId(const std::string &name, std::string &id) {
     int numRows = 0;
 
@@ -1099,6 +1131,113 @@ namespace aprsinject {
     return (numRows > 0) ? true : false;
   } // DBI::getMaidenheadId
 
+  //
+  // newest first, pass the last id handed back as before to get
+  // the next chunk, 0 starts from the top, only ids past after
+  // come back
+  //
+  bool DBI::getIds(const std::string &table, const std::string &column, const sqlid_t after, const sqlid_t before, const size_t limit, idrows_t &ret) {
+    try {
+      mysqlpp::Query query = _sqlpp->query();
+      query << "SELECT id, " << column << " FROM " << table
+            << " WHERE id > " << after;
+      if (before) query << " AND id < " << before;
+      query << " ORDER BY id DESC LIMIT " << limit;
+
+      mysqlpp::StoreQueryResult res = query.store();
+
+      for(size_t i=0; i < res.num_rows();  i++)
+        ret.push_back( idrow_t(strtoull(res[i][0].c_str(), NULL, 10), res[i][1].c_str()) );
+    } // try
+    catch(const mysqlpp::BadQuery &e) {
+      TLOG(LogWarn, << "*** MySQL++ Error{getIds}: #"
+                    << e.errnum()
+                    << " " << e.what()
+                    << std::endl);
+      if (e.errnum() >= 2000 && e.errnum() < 3000) reconnect();
+      return false;
+    } // catch
+    catch(const mysqlpp::Exception &e) {
+      TLOG(LogWarn, << "*** MySQL++ Error{getIds}: "
+                    << " " << e.what()
+                    << std::endl);
+      return false;
+    } // catch
+
+    return true;
+  } // DBI::getIds
+
+  //
+  // func is applied to each name the same way the single row
+  // lookups and inserts do, TRIM or UPPER, or nothing when empty
+  //
+  bool DBI::getIdsByName(const std::string &table, const std::string &column, const std::string &func, const std::vector<std::string> &names, idrows_t &ret) {
+    if (names.empty()) return true;
+
+    try {
+      mysqlpp::Query query = _sqlpp->query();
+      query << "SELECT id, " << column << " FROM " << table
+            << " WHERE " << column << " IN (";
+      for(size_t i=0; i < names.size(); i++) {
+        if (i) query << ",";
+        query << func << "(" << mysqlpp::quote << names[i] << ")";
+      } // for
+      query << ")";
+
+      mysqlpp::StoreQueryResult res = query.store();
+
+      for(size_t i=0; i < res.num_rows();  i++)
+        ret.push_back( idrow_t(strtoull(res[i][0].c_str(), NULL, 10), res[i][1].c_str()) );
+    } // try
+    catch(const mysqlpp::BadQuery &e) {
+      TLOG(LogWarn, << "*** MySQL++ Error{getIdsByName[" << table << "]}: #"
+                    << e.errnum()
+                    << " " << e.what()
+                    << std::endl);
+      if (e.errnum() >= 2000 && e.errnum() < 3000) reconnect();
+      return false;
+    } // catch
+    catch(const mysqlpp::Exception &e) {
+      TLOG(LogWarn, << "*** MySQL++ Error{getIdsByName[" << table << "]}: "
+                    << " " << e.what()
+                    << std::endl);
+      return false;
+    } // catch
+
+    return true;
+  } // DBI::getIdsByName
+
+  bool DBI::insertNames(const std::string &table, const std::string &column, const std::string &func, const std::vector<std::string> &names) {
+    if (names.empty()) return true;
+
+    try {
+      mysqlpp::Query query = _sqlpp->query();
+      query << "INSERT IGNORE INTO " << table << " (" << column << ") VALUES ";
+      for(size_t i=0; i < names.size(); i++) {
+        if (i) query << ",";
+        query << "( " << func << "(" << mysqlpp::quote << names[i] << ") )";
+      } // for
+
+      query.execute();
+    } // try
+    catch(mysqlpp::BadQuery &e) {
+      TLOG(LogWarn, << "*** MySQL++ Error{insertNames[" << table << "]}: #"
+                    << e.errnum()
+                    << " " << e.what()
+                    << std::endl);
+      if (e.errnum() >= 2000 && e.errnum() < 3000) reconnect();
+      return false;
+    } // catch
+    catch(mysqlpp::Exception &e) {
+      TLOG(LogWarn, << "*** MySQL++ Error{insertNames[" << table << "]}: "
+                    << " " << e.what()
+                    << std::endl);
+      return false;
+    } // catch
+
+    return true;
+  } // DBI::insertNames
+
   bool DBI::insertName(const std::string &name, std::string &id) {
     mysqlpp::SimpleResult res;
     int numRows = 0;
@@ -1350,7 +1489,7 @@ namespace aprsinject {
     return (numRows > 0) ? true : false;
   } // DBI::insertStaus
 
-  bool DBI::insertPacket(const std::string &packetId, const std::string &callsignId) {
+  bool DBI::insertPacket(const std::string &packetId, const sqlid_t callsignId) {
     mysqlpp::SimpleResult res;
     int numRows = 0;
 
@@ -1359,7 +1498,7 @@ namespace aprsinject {
       mysqlpp::Query query = _sqlpp->query();
       query << "INSERT INTO packet (id, callsign_id, create_ts) VALUES ("
             << "UUID_STRIP(" << mysqlpp::quote << packetId << "),"
-            << mysqlpp::quote << callsignId
+            << callsignId
             << ", UNIX_TIMESTAMP() )",
       res = query.execute();
       numRows = res.rows();
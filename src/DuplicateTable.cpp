@@ -0,0 +1,127 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+
+#include <new>
+#include <cassert>
+
+#include <openframe/openframe.h>
+
+#include "DuplicateTable.h"
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** DuplicateTable Class                                                 **
+ **************************************************************************/
+  const time_t DuplicateTable::kDefaultWindow		= 30;
+  const size_t DuplicateTable::kDefaultStripes		= 64;
+
+  DuplicateTable::DuplicateTable(const time_t window, const size_t num_stripes) :
+    _window(window), _num_stripes(num_stripes ? num_stripes : kDefaultStripes) {
+
+    try {
+      _stripes = new stripe_t[_num_stripes];
+    } // try
+    catch(std::bad_alloc &xa) {
+      assert(false);
+    } // catch
+
+    for(size_t i=0; i < _num_stripes; i++) {
+      pthread_mutex_init(&_stripes[i].lock, NULL);
+      // one bucket per second plus the one we're filling
+      _stripes[i].buckets.resize(_window + 1);
+      _stripes[i].last_sweep = time(NULL);
+    } // for
+  } // DuplicateTable::DuplicateTable
+
+  DuplicateTable::~DuplicateTable() {
+    for(size_t i=0; i < _num_stripes; i++)
+      pthread_mutex_destroy(&_stripes[i].lock);
+
+    delete [] _stripes;
+  } // DuplicateTable::~DuplicateTable
+
+  // Empty every bucket whose second has come around again since the
+  // last sweep, a key only goes if it wasn't filed again since.
+  void DuplicateTable::sweep(stripe_t &stripe, const time_t now) {
+    time_t elapsed = now - stripe.last_sweep;
+    if (elapsed <= 0) return;
+
+    time_t num_buckets = stripe.buckets.size();
+    if (elapsed > num_buckets) elapsed = num_buckets;
+
+    for(time_t t = now - elapsed + 1; t <= now; t++) {
+      bucket_t &bucket = stripe.buckets[t % num_buckets];
+      for(bucket_t::iterator itr = bucket.begin(); itr != bucket.end(); itr++) {
+        seen_itr sitr = stripe.seen.find(*itr);
+        if (sitr != stripe.seen.end() && sitr->second.inserted <= t - num_buckets)
+          stripe.seen.erase(sitr);
+      } // for
+      bucket.clear();
+    } // for
+
+    stripe.last_sweep = now;
+  } // DuplicateTable::sweep
+
+  void DuplicateTable::insert(stripe_t &stripe, const key_t key, const time_t timestamp, const time_t now) {
+    entry_t &entry = stripe.seen[key];
+    entry.timestamp = timestamp;
+    entry.inserted = now;
+    stripe.buckets[now % stripe.buckets.size()].push_back(key);
+  } // DuplicateTable::insert
+
+  bool DuplicateTable::check(const key_t key, const time_t timestamp, const time_t now) {
+    stripe_t &stripe = stripe_for(key);
+
+    pthread_mutex_lock(&stripe.lock);
+    sweep(stripe, now);
+
+    seen_itr itr = stripe.seen.find(key);
+    bool is_dup = itr != stripe.seen.end() && now - itr->second.timestamp < _window;
+    if (!is_dup) insert(stripe, key, timestamp, now);
+    pthread_mutex_unlock(&stripe.lock);
+
+    return is_dup;
+  } // DuplicateTable::check
+
+  void DuplicateTable::add(const key_t key, const time_t timestamp, const time_t now) {
+    stripe_t &stripe = stripe_for(key);
+
+    pthread_mutex_lock(&stripe.lock);
+    sweep(stripe, now);
+    insert(stripe, key, timestamp, now);
+    pthread_mutex_unlock(&stripe.lock);
+  } // DuplicateTable::add
+
+  size_t DuplicateTable::size() const {
+    size_t ret = 0;
+    for(size_t i=0; i < _num_stripes; i++) {
+      pthread_mutex_lock(&_stripes[i].lock);
+      ret += _stripes[i].seen.size();
+      pthread_mutex_unlock(&_stripes[i].lock);
+    } // for
+
+    return ret;
+  } // DuplicateTable::size
+
+} // namespace aprsinject
@@ -0,0 +1,127 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+
+#include <cassert>
+#include <cerrno>
+
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <sys/time.h>
+
+#include <openframe/openframe.h>
+
+#include "EventLoop.h"
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** EventLoop Class                                                      **
+ **************************************************************************/
+  const time_t EventLoop::kTickInterval		= 1;
+
+  EventLoop::EventLoop(const time_t tick) : _armed(0), _signalled_at(0.0), _wake_latency(0.0) {
+    _epoll_fd = epoll_create(4);
+    assert(_epoll_fd != -1);
+
+    _wake_fd = eventfd(0, EFD_NONBLOCK);
+    assert(_wake_fd != -1);
+
+    _tick_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    assert(_tick_fd != -1);
+
+    struct itimerspec its;
+    its.it_interval.tv_sec = tick;
+    its.it_interval.tv_nsec = 0;
+    its.it_value = its.it_interval;
+    timerfd_settime(_tick_fd, 0, &its, NULL);
+
+    add(_wake_fd);
+    add(_tick_fd);
+  } // EventLoop::EventLoop
+
+  EventLoop::~EventLoop() {
+    close(_tick_fd);
+    close(_wake_fd);
+    close(_epoll_fd);
+  } // EventLoop::~EventLoop
+
+  double EventLoop::now() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + (tv.tv_usec / 1000000.0);
+  } // EventLoop::now
+
+  bool EventLoop::add(const int fd) {
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    return epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, fd, &ev) == 0;
+  } // EventLoop::add
+
+  bool EventLoop::remove(const int fd) {
+    struct epoll_event ev;
+    return epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, fd, &ev) == 0;
+  } // EventLoop::remove
+
+  void EventLoop::wake() {
+    // pairs with the barrier in arm()
+    __sync_synchronize();
+    if (!__sync_bool_compare_and_swap(&_armed, 1, 0)) return;
+
+    _signalled_at = now();
+    uint64_t one = 1;
+    ssize_t ret = write(_wake_fd, &one, sizeof(one));
+    (void) ret;
+  } // EventLoop::wake
+
+  int EventLoop::wait(const int timeout_ms) {
+    struct epoll_event events[4];
+    int num_events = epoll_wait(_epoll_fd, events, 4, timeout_ms);
+    _armed = 0;
+
+    int ret = eventNone;
+    uint64_t count;
+    for(int i=0; i < num_events; i++) {
+      int fd = events[i].data.fd;
+      if (fd == _wake_fd) {
+        ssize_t n = read(_wake_fd, &count, sizeof(count));
+        (void) n;
+        _wake_latency = now() - _signalled_at;
+        ret |= eventWake;
+      } // if
+      else if (fd == _tick_fd) {
+        ssize_t n = read(_tick_fd, &count, sizeof(count));
+        (void) n;
+        ret |= eventTick;
+      } // else if
+      else
+        ret |= eventReadable;
+    } // for
+
+    return ret;
+  } // EventLoop::wait
+
+} // namespace aprsinject
@@ -0,0 +1,258 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+
+#include "config.h"
+
+#include <string>
+#include <cassert>
+#include <cstring>
+#include <cerrno>
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
+
+#include <openframe/openframe.h>
+
+#include "FileSource.h"
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** FileSource Class                                                     **
+ **************************************************************************/
+  const size_t FileSource::kDefaultBatch	= 100;
+  const size_t FileSource::kReadChunk		= 256 * 1024;
+
+  FileSource::FileSource(const std::string &path, const std::string &speed, const size_t batch) :
+    _path(path),
+    _speed_str(speed),
+    _batch(batch ? batch : kDefaultBatch),
+    _eof(false),
+    _fd(-1),
+    _map(NULL),
+    _map_size(0),
+    _gz(NULL),
+    _data(NULL),
+    _length(0),
+    _pos(0),
+    _lines(0),
+    _first_epoch(0),
+    _started(0.0) {
+
+    _speed = string_to_speed(speed);
+    _is_gzip = path.length() > 3 && path.compare(path.length() - 3, 3, ".gz") == 0;
+
+#ifndef HAVE_LIBZ
+    if (_is_gzip) throw InputSource_Exception("not built with zlib, can't read " + path);
+#endif
+  } // FileSource::FileSource
+
+  FileSource::~FileSource() {
+    close();
+  } // FileSource::~FileSource
+
+  double FileSource::string_to_speed(const std::string &speed) {
+    if (speed.empty() || speed == "max") return 0.0;
+    if (speed == "realtime") return 1.0;
+
+    char *end;
+    double ret = strtod(speed.c_str(), &end);
+    if (end == speed.c_str() || (*end != '\0' && strcmp(end, "x") != 0) || ret <= 0.0)
+      throw InputSource_Exception("invalid replay speed \"" + speed + "\", want realtime, max or Nx");
+
+    return ret;
+  } // FileSource::string_to_speed
+
+  bool FileSource::open() {
+    if (_fd != -1 || _gz) return true;
+
+#ifdef HAVE_LIBZ
+    if (_is_gzip) {
+      gzFile gz = gzopen(_path.c_str(), "rb");
+      if (gz == NULL) {
+        _error = "could not open " + _path + "; " + strerror(errno);
+        return false;
+      } // if
+      gzbuffer(gz, kReadChunk);
+      _gz = gz;
+      return true;
+    } // if
+#endif
+
+    _fd = ::open(_path.c_str(), O_RDONLY);
+    if (_fd == -1) {
+      _error = "could not open " + _path + "; " + strerror(errno);
+      return false;
+    } // if
+
+    struct stat st;
+    if (fstat(_fd, &st) == -1) {
+      _error = "could not stat " + _path + "; " + strerror(errno);
+      close();
+      return false;
+    } // if
+
+    _map_size = st.st_size;
+    if (_map_size == 0) {
+      _eof = true;
+      return true;
+    } // if
+
+    _map = mmap(NULL, _map_size, PROT_READ, MAP_PRIVATE, _fd, 0);
+    if (_map == MAP_FAILED) {
+      _map = NULL;
+      _error = "could not map " + _path + "; " + strerror(errno);
+      close();
+      return false;
+    } // if
+    madvise(_map, _map_size, MADV_SEQUENTIAL);
+
+    _data = static_cast<const char *>(_map);
+    _length = _map_size;
+    _pos = 0;
+    return true;
+  } // FileSource::open
+
+  void FileSource::close() {
+    if (_map) munmap(_map, _map_size);
+    if (_fd != -1) ::close(_fd);
+#ifdef HAVE_LIBZ
+    if (_gz) gzclose( static_cast<gzFile>(_gz) );
+#endif
+    _map = NULL;
+    _map_size = 0;
+    _fd = -1;
+    _gz = NULL;
+  } // FileSource::close
+
+  // Only ever called once everything handed out of _buf has been
+  // released, keeps the partial line at the end for the next round.
+  bool FileSource::fill() {
+#ifdef HAVE_LIBZ
+    if (_gz == NULL) return false;
+
+    _buf.erase(0, _pos);
+    _pos = 0;
+
+    size_t carry = _buf.length();
+    _buf.resize(carry + kReadChunk);
+    int n = gzread(static_cast<gzFile>(_gz), &_buf[carry], kReadChunk);
+    if (n < 0) {
+      int errnum;
+      _error = gzerror(static_cast<gzFile>(_gz), &errnum);
+      n = 0;
+    } // if
+    _buf.resize(carry + n);
+
+    _data = _buf.data();
+    _length = _buf.length();
+    return n > 0;
+#else
+    return false;
+#endif
+  } // FileSource::fill
+
+  bool FileSource::is_due(const time_t epoch) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    double now = tv.tv_sec + (tv.tv_usec / 1000000.0);
+
+    if (_started == 0.0) {
+      _first_epoch = epoch;
+      _started = now;
+    } // if
+
+    if (_speed == 0.0) return true;
+    return now >= _started + double(epoch - _first_epoch) / _speed;
+  } // FileSource::is_due
+
+  bool FileSource::next(InputBatch &batch) {
+    if (_eof) return false;
+
+    // mapped files are done when we've walked off the end, gzip files
+    // when there's nothing left to inflate
+    if (_pos >= _length || memchr(_data + _pos, '\n', _length - _pos) == NULL) {
+      if (!fill()) {
+        if (_pos >= _length) {
+          _eof = true;
+          return false;
+        } // if
+
+        // the capture didn't end with a newline, finish off the last
+        // line so it goes out like the rest instead of being dropped
+        std::string tail(_data + _pos, _length - _pos);
+        tail += '\n';
+        _buf = tail;
+        _data = _buf.data();
+        _length = _buf.length();
+        _pos = 0;
+      } // if
+    } // if
+
+    LineSlicer ls(_data + _pos, _length - _pos);
+    const char *start = _data + _pos;
+    const char *end = start;
+    size_t num_lines = 0;
+    Slice line;
+    while(num_lines < _batch) {
+      LineSlicer peek = ls;
+      if (!peek.next(line)) break;
+
+      // hold the rest back until the clock catches up with them
+      Slice epoch_str, body;
+      if (_speed != 0.0 && line.split(' ', epoch_str, body) && !is_due(epoch_str.to_long()))
+        break;
+
+      ls = peek;
+      end = line.data() + line.length() + 1;
+      ++num_lines;
+    } // while
+
+    if (num_lines == 0) return false;
+
+    _pos += end - start;
+    _lines += num_lines;
+    batch.id.clear();
+    batch.body = Slice(start, end - start);
+    batch.handle = NULL;
+    return true;
+  } // FileSource::next
+
+  void FileSource::release(InputBatch &batch) {
+    // nothing to give back, the window only moves in next()
+    batch.body = Slice();
+  } // FileSource::release
+
+  std::string FileSource::describe() {
+    return "file " + _path + " at " + (_speed_str.empty() ? std::string("max") : _speed_str);
+  } // FileSource::describe
+
+} // namespace aprsinject
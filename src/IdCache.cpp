@@ -0,0 +1,243 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+
+#include <new>
+#include <cassert>
+
+#include <openframe/openframe.h>
+
+#include "IdCache.h"
+#include "IdSnapshot.h"
+#include "KeyHash.h"
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** IdCache Class                                                        **
+ **************************************************************************/
+  const size_t IdCache::kDefaultCapacity		= 65536;
+  const size_t IdCache::kDefaultStripes			= 16;
+
+  IdCache::IdCache(const size_t num_stripes) :
+    _num_stripes(num_stripes ? num_stripes : kDefaultStripes),
+    _snapshot(NULL),
+    _last_report_at(0) {
+
+    for(int ns=0; ns < nsMax; ns++) {
+      try {
+        _stripes[ns] = new stripe_t[_num_stripes];
+      } // try
+      catch(std::bad_alloc &xa) {
+        assert(false);
+      } // catch
+
+      for(size_t i=0; i < _num_stripes; i++) {
+        pthread_mutex_init(&_stripes[ns][i].lock, NULL);
+        _stripes[ns][i].hand = 0;
+      } // for
+
+      set_capacity( static_cast<namespaceEnum>(ns), kDefaultCapacity);
+    } // for
+  } // IdCache::IdCache
+
+  IdCache::~IdCache() {
+    for(int ns=0; ns < nsMax; ns++) {
+      for(size_t i=0; i < _num_stripes; i++)
+        pthread_mutex_destroy(&_stripes[ns][i].lock);
+
+      delete [] _stripes[ns];
+    } // for
+  } // IdCache::~IdCache
+
+  IdCache &IdCache::set_capacity(const namespaceEnum ns, const size_t capacity) {
+    assert(ns < nsMax);		// bug
+
+    _capacity[ns] = capacity;
+
+    // round up so the stripes together hold at least capacity
+    size_t per_stripe = (capacity + _num_stripes - 1) / _num_stripes;
+    for(size_t i=0; i < _num_stripes; i++) {
+      stripe_t &stripe = _stripes[ns][i];
+      pthread_mutex_lock(&stripe.lock);
+      stripe.index.clear();
+      slots_t().swap(stripe.slots);
+      stripe.capacity = per_stripe;
+      stripe.hand = 0;
+      pthread_mutex_unlock(&stripe.lock);
+    } // for
+
+    return *this;
+  } // IdCache::set_capacity
+
+  bool IdCache::find(const namespaceEnum ns, const key_t key, sqlid_t &ret_id) {
+    assert(ns < nsMax);		// bug
+    if (!_capacity[ns]) return false;
+
+    stripe_t &stripe = stripe_for(ns, key);
+
+    pthread_mutex_lock(&stripe.lock);
+    index_itr itr = stripe.index.find(key);
+    bool found = itr != stripe.index.end();
+    if (found) {
+      slot_t &slot = stripe.slots[itr->second];
+      slot.referenced = true;
+      ret_id = slot.id;
+    } // if
+    pthread_mutex_unlock(&stripe.lock);
+
+    if (!found && _snapshot && _snapshot->find(ns, key, ret_id)) {
+      store(ns, key, ret_id);
+      found = true;
+    } // if
+
+    return found;
+  } // IdCache::find
+
+  void IdCache::store(const namespaceEnum ns, const key_t key, const sqlid_t id) {
+    assert(ns < nsMax);		// bug
+    if (!_capacity[ns]) return;
+
+    stripe_t &stripe = stripe_for(ns, key);
+
+    pthread_mutex_lock(&stripe.lock);
+    index_itr itr = stripe.index.find(key);
+    if (itr != stripe.index.end()) {
+      stripe.slots[itr->second].id = id;
+      pthread_mutex_unlock(&stripe.lock);
+      return;
+    } // if
+
+    size_t pos;
+    if (stripe.slots.size() < stripe.capacity) {
+      pos = stripe.slots.size();
+      stripe.slots.push_back(slot_t());
+    } // if
+    else {
+      // sweep the hand forward, anything looked up since it last
+      // came by gets another lap
+      while(stripe.slots[stripe.hand].referenced) {
+        stripe.slots[stripe.hand].referenced = false;
+        stripe.hand = (stripe.hand + 1) % stripe.slots.size();
+      } // while
+
+      pos = stripe.hand;
+      stripe.index.erase(stripe.slots[pos].key);
+      stripe.hand = (stripe.hand + 1) % stripe.slots.size();
+    } // else
+
+    slot_t &slot = stripe.slots[pos];
+    slot.key = key;
+    slot.id = id;
+    slot.referenced = false;
+    stripe.index[key] = pos;
+    pthread_mutex_unlock(&stripe.lock);
+  } // IdCache::store
+
+  size_t IdCache::size(const namespaceEnum ns) const {
+    assert(ns < nsMax);		// bug
+
+    size_t ret = 0;
+    for(size_t i=0; i < _num_stripes; i++) {
+      pthread_mutex_lock(&_stripes[ns][i].lock);
+      ret += _stripes[ns][i].index.size();
+      pthread_mutex_unlock(&_stripes[ns][i].lock);
+    } // for
+
+    return ret;
+  } // IdCache::size
+
+  void IdCache::dump(const namespaceEnum ns, pairs_t &ret) const {
+    assert(ns < nsMax);		// bug
+
+    for(size_t i=0; i < _num_stripes; i++) {
+      const stripe_t &stripe = _stripes[ns][i];
+      pthread_mutex_lock(&_stripes[ns][i].lock);
+      for(slots_t::const_iterator itr = stripe.slots.begin(); itr != stripe.slots.end(); itr++)
+        ret.push_back( pair_t(itr->key, itr->id) );
+      pthread_mutex_unlock(&_stripes[ns][i].lock);
+    } // for
+  } // IdCache::dump
+
+  bool IdCache::claim_report(const time_t interval) {
+    time_t now = time(NULL);
+    time_t last = _last_report_at;
+    if (last > now - interval) return false;
+
+    return __sync_bool_compare_and_swap(&_last_report_at, last, now);
+  } // IdCache::claim_report
+
+  // Close enough for a stat, the slots plus a red-black tree node
+  // per entry in the index.
+  size_t IdCache::memory(const namespaceEnum ns) const {
+    assert(ns < nsMax);		// bug
+
+    size_t ret = 0;
+    for(size_t i=0; i < _num_stripes; i++) {
+      pthread_mutex_lock(&_stripes[ns][i].lock);
+      ret += _stripes[ns][i].slots.capacity() * sizeof(slot_t);
+      ret += _stripes[ns][i].index.size() * (sizeof(index_t::value_type) + 4 * sizeof(void *));
+      pthread_mutex_unlock(&_stripes[ns][i].lock);
+    } // for
+
+    return ret;
+  } // IdCache::memory
+
+  const char *IdCache::namespace_to_string(const namespaceEnum ns) {
+    switch(ns) {
+      case nsCallsign:
+        return "callsign";
+      case nsName:
+        return "name";
+      case nsDest:
+        return "dest";
+      case nsDigi:
+        return "digi";
+      case nsMaidenhead:
+        return "maidenhead";
+      default:
+        break;
+    } // switch
+
+    return "unknown";
+  } // IdCache::namespace_to_string
+
+  // The database compares these case insensitively, apart from the
+  // locators, and object names are trimmed before they're looked up.
+  IdCache::key_t IdCache::key_for(const namespaceEnum ns, const std::string &name) {
+    switch(ns) {
+      case nsMaidenhead:
+        return KeyHash::hash(name);
+      case nsName: {
+        std::string::size_type start = name.find_first_not_of(" \t");
+        if (start == std::string::npos) return KeyHash::hash("");
+        std::string::size_type end = name.find_last_not_of(" \t");
+        return KeyHash(KeyHash::foldLower).update(name.data() + start, end - start + 1).digest();
+      } // case
+      default:
+        break;
+    } // switch
+
+    return KeyHash::hash(name, KeyHash::foldLower);
+  } // IdCache::key_for
+
+} // namespace aprsinject
@@ -0,0 +1,205 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+
+#include <algorithm>
+#include <string>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <openframe/openframe.h>
+
+#include "IdSnapshot.h"
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** IdSnapshot Class                                                     **
+ **************************************************************************/
+  const uint32_t IdSnapshot::kMagic		= 0x53444941;	// "AIDS"
+  const uint32_t IdSnapshot::kVersion		= 1;
+
+  static bool entry_key_less(const IdSnapshot::entry_t &a, const IdSnapshot::entry_t &b) {
+    return a.key < b.key;
+  } // entry_key_less
+
+  static bool entry_key_equal(const IdSnapshot::entry_t &a, const IdSnapshot::entry_t &b) {
+    return a.key == b.key;
+  } // entry_key_equal
+
+  IdSnapshot::IdSnapshot() : _map(NULL), _map_size(0) {
+    close();
+  } // IdSnapshot::IdSnapshot
+
+  IdSnapshot::~IdSnapshot() {
+    close();
+  } // IdSnapshot::~IdSnapshot
+
+  bool IdSnapshot::open(const std::string &path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+      _error = "could not open " + path + "; " + strerror(errno);
+      return false;
+    } // if
+
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+      _error = "could not stat " + path + "; " + strerror(errno);
+      ::close(fd);
+      return false;
+    } // if
+
+    if (static_cast<size_t>(st.st_size) < sizeof(header_t)) {
+      _error = path + " is too short to be a snapshot";
+      ::close(fd);
+      return false;
+    } // if
+
+    _map_size = st.st_size;
+    _map = mmap(NULL, _map_size, PROT_READ, MAP_SHARED, fd, 0);
+    // the mapping keeps the file around, even if it's replaced
+    ::close(fd);
+    if (_map == MAP_FAILED) {
+      _map = NULL;
+      _error = "could not map " + path + "; " + strerror(errno);
+      return false;
+    } // if
+
+    const header_t *header = static_cast<const header_t *>(_map);
+    if (header->magic != kMagic || header->version != kVersion) {
+      close();
+      _error = path + " is not a version " + openframe::stringify<uint32_t>(kVersion) + " snapshot";
+      return false;
+    } // if
+
+    // make sure every array is really there before trusting counts
+    size_t offset = sizeof(header_t);
+    for(int ns=0; ns < IdCache::nsMax; ns++) {
+      if (header->count[ns] > (_map_size - offset) / sizeof(entry_t)) {
+        close();
+        _error = path + " is truncated";
+        return false;
+      } // if
+
+      _entries[ns] = reinterpret_cast<const entry_t *>(static_cast<const char *>(_map) + offset);
+      _count[ns] = header->count[ns];
+      _max_id[ns] = header->max_id[ns];
+      offset += _count[ns] * sizeof(entry_t);
+    } // for
+
+    // lookups are scattered, don't bother reading ahead
+    madvise(_map, _map_size, MADV_RANDOM);
+    return true;
+  } // IdSnapshot::open
+
+  void IdSnapshot::close() {
+    if (_map) munmap(_map, _map_size);
+    _map = NULL;
+    _map_size = 0;
+
+    for(int ns=0; ns < IdCache::nsMax; ns++) {
+      _entries[ns] = NULL;
+      _count[ns] = 0;
+      _max_id[ns] = 0;
+    } // for
+  } // IdSnapshot::close
+
+  bool IdSnapshot::find(const IdCache::namespaceEnum ns, const IdCache::key_t key, sqlid_t &ret_id) const {
+    assert(ns < IdCache::nsMax);		// bug
+    if (!_count[ns]) return false;
+
+    entry_t want;
+    want.key = key;
+    const entry_t *end = _entries[ns] + _count[ns];
+    const entry_t *found = std::lower_bound(_entries[ns], end, want, entry_key_less);
+    if (found == end || found->key != key) return false;
+
+    ret_id = found->id;
+    return true;
+  } // IdSnapshot::find
+
+  size_t IdSnapshot::size() const {
+    size_t ret = 0;
+    for(int ns=0; ns < IdCache::nsMax; ns++)
+      ret += _count[ns];
+
+    return ret;
+  } // IdSnapshot::size
+
+  void IdSnapshot::copy(const IdCache::namespaceEnum ns, entries_t &ret) const {
+    assert(ns < IdCache::nsMax);		// bug
+    ret.insert(ret.end(), _entries[ns], _entries[ns] + _count[ns]);
+  } // IdSnapshot::copy
+
+  bool IdSnapshot::write(const std::string &path, entries_t entries[IdCache::nsMax], std::string &error) {
+    header_t header;
+    memset(&header, 0, sizeof(header) );
+    header.magic = kMagic;
+    header.version = kVersion;
+
+    for(int ns=0; ns < IdCache::nsMax; ns++) {
+      entries_t &e = entries[ns];
+      std::stable_sort(e.begin(), e.end(), entry_key_less);
+      e.erase( std::unique(e.begin(), e.end(), entry_key_equal), e.end() );
+
+      header.count[ns] = e.size();
+      for(entries_t::const_iterator itr = e.begin(); itr != e.end(); itr++)
+        header.max_id[ns] = std::max<uint64_t>(header.max_id[ns], itr->id);
+    } // for
+
+    // written aside and renamed over so a reader never sees half
+    std::string tmp = path + ".tmp";
+    FILE *fp = fopen(tmp.c_str(), "wb");
+    if (fp == NULL) {
+      error = "could not open " + tmp + "; " + strerror(errno);
+      return false;
+    } // if
+
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+    for(int ns=0; ok && ns < IdCache::nsMax; ns++) {
+      if (entries[ns].empty()) continue;
+      ok = fwrite(&entries[ns][0], sizeof(entry_t), entries[ns].size(), fp) == entries[ns].size();
+    } // for
+
+    ok = ok && fflush(fp) == 0 && fsync( fileno(fp) ) == 0;
+    if (!ok) error = "could not write " + tmp + "; " + strerror(errno);
+    fclose(fp);
+
+    if (ok && rename(tmp.c_str(), path.c_str()) == -1) {
+      error = "could not rename " + tmp + "; " + strerror(errno);
+      ok = false;
+    } // if
+
+    if (!ok) unlink( tmp.c_str() );
+    return ok;
+  } // IdSnapshot::write
+
+} // namespace aprsinject
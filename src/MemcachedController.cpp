@@ -83,6 +83,12 @@ namespace aprsinject {
       throw MemcachedController_Exception("unable to push memcached server list; "
         + std::string(memcached_strerror(_st, rc)));
 
+    // needed for gets() to hand back cas values
+    rc = memcached_behavior_set(_st, MEMCACHED_BEHAVIOR_SUPPORT_CAS, 1);
+    if (rc != MEMCACHED_SUCCESS)
+      throw MemcachedController_Exception("unable to enable memcached cas support; "
+        + std::string(memcached_strerror(_st, rc)));
+
   } // MemcachedController::MemcachedController
 
   MemcachedController::~MemcachedController() {
@@ -148,6 +154,155 @@ namespace aprsinject {
 
   } // MemcachedController::replace
 
+  const MemcachedController::memcachedReturnEnum MemcachedController::add(const std::string &ns, const std::string &key, const std::string &value, const time_t expires) {
+    std::string cacheKey = ns + ":" + key;
+    memcached_return rc;
+    uint32_t optflags = 0;
+
+    assert(_st != NULL);		// bug
+
+    if (cacheKey.length() < 1)
+      throw MemcachedController_Exception("memcached namespace and key must not be 0 length");
+
+    if (cacheKey.length() > 255)
+      throw MemcachedController_Exception("memcached namespace and key must be less than 256 characters");
+
+    rc = memcached_add(_st, cacheKey.c_str(), cacheKey.length(), value.data(), value.size(),
+                       expires, optflags);
+
+    switch(rc) {
+      case MEMCACHED_SUCCESS:
+        return MEMCACHED_CONTROLLER_SUCCESS;
+      case MEMCACHED_NOTSTORED:
+      case MEMCACHED_DATA_EXISTS:
+        return MEMCACHED_CONTROLLER_EXISTS;
+      default:
+        break;
+    } // switch
+
+    throw MemcachedController_Exception("memcached unable to add; "
+          + std::string(memcached_strerror(_st, rc)));
+  } // MemcachedController::add
+
+  const MemcachedController::memcachedReturnEnum MemcachedController::cas(const std::string &ns, const std::string &key, const std::string &value, const time_t expires, const uint64_t cas) {
+    std::string cacheKey = ns + ":" + key;
+    memcached_return rc;
+    uint32_t optflags = 0;
+
+    assert(_st != NULL);		// bug
+
+    if (cacheKey.length() < 1)
+      throw MemcachedController_Exception("memcached namespace and key must not be 0 length");
+
+    if (cacheKey.length() > 255)
+      throw MemcachedController_Exception("memcached namespace and key must be less than 256 characters");
+
+    rc = memcached_cas(_st, cacheKey.c_str(), cacheKey.length(), value.data(), value.size(),
+                       expires, optflags, cas);
+
+    switch(rc) {
+      case MEMCACHED_SUCCESS:
+        return MEMCACHED_CONTROLLER_SUCCESS;
+      case MEMCACHED_DATA_EXISTS:
+        return MEMCACHED_CONTROLLER_EXISTS;
+      case MEMCACHED_NOTFOUND:
+        return MEMCACHED_CONTROLLER_NOTFOUND;
+      default:
+        break;
+    } // switch
+
+    throw MemcachedController_Exception("memcached unable to cas; "
+          + std::string(memcached_strerror(_st, rc)));
+  } // MemcachedController::cas
+
+  const MemcachedController::memcachedReturnEnum MemcachedController::gets(const std::string &ns, const std::string &key, std::string &buf, uint64_t &cas) {
+    std::string cacheKey = ns + ":" + key;
+    memcachedReturnEnum ret = MEMCACHED_CONTROLLER_NOTFOUND;
+    memcached_result_st *result;
+    memcached_return rc;
+    const char *keys[1];
+    size_t key_length[1];
+
+    assert(_st != NULL);		// bug
+
+    if (cacheKey.length() < 1)
+      throw MemcachedController_Exception("memcached namespace and key must not be 0 length");
+
+    if (cacheKey.length() > 255)
+      throw MemcachedController_Exception("memcached namespace and key must be less than 256 characters");
+
+    keys[0] = cacheKey.c_str();
+    key_length[0] = cacheKey.length();
+
+    rc = memcached_mget(_st, keys, key_length, 1);
+    if (rc != MEMCACHED_SUCCESS)
+      throw MemcachedController_Exception("memcached unable to gets; "
+            + std::string(memcached_strerror(_st, rc)));
+
+    // always drain to the end so the connection is left clean
+    while( (result = memcached_fetch_result(_st, NULL, &rc)) != NULL) {
+      if (rc == MEMCACHED_SUCCESS && ret != MEMCACHED_CONTROLLER_SUCCESS) {
+        buf = std::string(memcached_result_value(result), memcached_result_length(result));
+        cas = memcached_result_cas(result);
+        ret = MEMCACHED_CONTROLLER_SUCCESS;
+      } // if
+      memcached_result_free(result);
+    } // while
+
+    if (rc != MEMCACHED_SUCCESS && rc != MEMCACHED_END && rc != MEMCACHED_NOTFOUND)
+      throw MemcachedController_Exception("memcached unable to gets; "
+            + std::string(memcached_strerror(_st, rc)));
+
+    return ret;
+  } // MemcachedController::gets
+
+  void MemcachedController::mget(const std::string &ns, const std::vector<std::string> &keys, std::map<std::string, std::string> &ret) {
+    std::vector<std::string> cacheKeys;
+    std::vector<const char *> key_ptrs;
+    std::vector<size_t> key_lengths;
+    memcached_result_st *result;
+    memcached_return rc;
+
+    assert(_st != NULL);		// bug
+
+    if (keys.empty()) return;
+
+    cacheKeys.reserve( keys.size() );
+    for(size_t i=0; i < keys.size(); i++) {
+      cacheKeys.push_back(ns + ":" + keys[i]);
+
+      if (cacheKeys.back().length() < 1)
+        throw MemcachedController_Exception("memcached namespace and key must not be 0 length");
+
+      if (cacheKeys.back().length() > 255)
+        throw MemcachedController_Exception("memcached namespace and key must be less than 256 characters");
+    } // for
+
+    // pointers last, cacheKeys is done growing
+    for(size_t i=0; i < cacheKeys.size(); i++) {
+      key_ptrs.push_back( cacheKeys[i].c_str() );
+      key_lengths.push_back( cacheKeys[i].length() );
+    } // for
+
+    rc = memcached_mget(_st, &key_ptrs[0], &key_lengths[0], key_ptrs.size());
+    if (rc != MEMCACHED_SUCCESS)
+      throw MemcachedController_Exception("memcached unable to mget; "
+            + std::string(memcached_strerror(_st, rc)));
+
+    size_t prefix = ns.length() + 1;
+    while( (result = memcached_fetch_result(_st, NULL, &rc)) != NULL) {
+      size_t key_length = memcached_result_key_length(result);
+      if (rc == MEMCACHED_SUCCESS && key_length > prefix)
+        ret[ std::string(memcached_result_key_value(result) + prefix, key_length - prefix) ] =
+          std::string(memcached_result_value(result), memcached_result_length(result));
+      memcached_result_free(result);
+    } // while
+
+    if (rc != MEMCACHED_SUCCESS && rc != MEMCACHED_END && rc != MEMCACHED_NOTFOUND)
+      throw MemcachedController_Exception("memcached unable to mget; "
+            + std::string(memcached_strerror(_st, rc)));
+  } // MemcachedController::mget
+
   const MemcachedController::memcachedReturnEnum MemcachedController::get(const std::string &ns, const std::string &key, std::string &buf) {
     std::string cacheKey = ns + ":" + key;
     memcachedReturnEnum ret;
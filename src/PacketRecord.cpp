@@ -0,0 +1,131 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+
+#include <string>
+#include <cstdlib>
+#include <cassert>
+
+#include <openframe/openframe.h>
+#include <aprs/aprs.h>
+
+#include "PacketRecord.h"
+#include "Validator.h"
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** PacketRecord Struct                                                  **
+ **************************************************************************/
+  void PacketRecord::clear() {
+    type = aprs::APRS::APRS_PACKET_UNKNOWN;
+    timestamp = 0;
+    is_object = false;
+    posdup = false;
+
+    // erase() keeps the buffers around for the next packet
+    packet_id.erase();
+    source.erase();
+    name.erase();
+    dest.erase();
+    target.erase();
+    locator.erase();
+    symbol_table.erase();
+    symbol_code.erase();
+    icon.erase();
+
+    has_position = false;
+    latitude = 0.0;
+    longitude = 0.0;
+
+    has_course = has_speed = has_altitude = false;
+    course = speed = altitude = 0;
+
+    callsign_id = name_id = icon_id = dest_id = maidenhead_id = target_id = 0;
+
+    num_digis = 0;
+    for(size_t i=0; i < kMaxDigis; i++) {
+      digis[i].erase();
+      digi_ids[i] = 0;
+    } // for
+  } // PacketRecord::clear
+
+  void PacketRecord::extract(aprs::APRS *aprs) {
+    assert(aprs != NULL);		// bug
+
+    clear();
+
+    type = aprs->packetType();
+    timestamp = aprs->timestamp();
+    is_object = aprs->is_object();
+
+    packet_id = aprs->getString("aprs.packet.uuid.id");
+    source = aprs->source();
+    if (aprs->isString("aprs.packet.object.name"))
+      name = aprs->getString("aprs.packet.object.name");
+    dest = aprs->getString("aprs.packet.path0");
+
+    if (type == aprs::APRS::APRS_PACKET_MESSAGE)
+      target = aprs->getString("aprs.packet.message.target");
+
+    if (type == aprs::APRS::APRS_PACKET_POSITION) {
+      has_position = true;
+      latitude = aprs->latitude();
+      longitude = aprs->longitude();
+      if (aprs->isString("aprs.packet.position.maidenhead"))
+        locator = aprs->getString("aprs.packet.position.maidenhead");
+    } // if
+
+    if (aprs->isString("aprs.packet.symbol.table") && aprs->isString("aprs.packet.symbol.code")) {
+      symbol_table = aprs->getString("aprs.packet.symbol.table");
+      symbol_code = aprs->getString("aprs.packet.symbol.code");
+    } // if
+
+    // same checks the queries used to make before these went into
+    // the database
+    Validator validator;
+    std::string buf = aprs->getString("aprs.packet.dirspd.direction");
+    has_course = buf.length() && validator.is_valid("is:int", buf);
+    if (has_course) course = atoi(buf.c_str());
+
+    buf = aprs->getString("aprs.packet.dirspd.speed");
+    has_speed = buf.length() && validator.is_valid("is:int", buf);
+    if (has_speed) speed = atoi(buf.c_str());
+
+    buf = aprs->getString("aprs.packet.altitude");
+    has_altitude = buf.length() && validator.is_valid("is:int", buf);
+    if (has_altitude) altitude = atoi(buf.c_str());
+
+    // the parser numbers the path from 1 after the destination,
+    // slots we never see stay empty with an id of 0
+    for(num_digis=0; num_digis < kMaxDigis; num_digis++) {
+      buf = aprs->getString("aprs.packet.path" + openframe::stringify<size_t>(num_digis+1));
+      if (!buf.length()) break;
+      digis[num_digis] = buf;
+    } // for
+  } // PacketRecord::extract
+
+  sqlid_t PacketRecord::to_id(const std::string &id) {
+    return strtoull(id.c_str(), NULL, 10);
+  } // PacketRecord::to_id
+
+} // namespace aprsinject
@@ -0,0 +1,148 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+#include <cassert>
+
+#include <openframe/openframe.h>
+
+#include "ParserPool.h"
+#include "Worker.h"
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** ParserPool Class                                                     **
+ **************************************************************************/
+  const size_t ParserPool::kDefaultMinBatch		= 16;
+
+  ParserPool::ParserPool(const size_t num_threads, const size_t min_batch) :
+    _num_threads(num_threads), _min_batch(min_batch) {
+    pthread_mutex_init(&_lock, NULL);
+    pthread_cond_init(&_work_cond, NULL);
+    pthread_cond_init(&_done_cond, NULL);
+
+    _jobs = NULL;
+    _generation = 0;
+    _active = 0;
+    _done = false;
+    _next = 0;
+    _remaining = 0;
+  } // ParserPool::ParserPool
+
+  ParserPool::~ParserPool() {
+    stop();
+
+    pthread_cond_destroy(&_done_cond);
+    pthread_cond_destroy(&_work_cond);
+    pthread_mutex_destroy(&_lock);
+  } // ParserPool::~ParserPool
+
+  void ParserPool::start() {
+    for(size_t i=0; i < _num_threads; i++) {
+      pthread_t thread_id;
+      pthread_create(&thread_id, NULL, ParserPool::ParserThread, this);
+      _threads.push_back(thread_id);
+    } // for
+  } // ParserPool::start
+
+  void ParserPool::stop() {
+    pthread_mutex_lock(&_lock);
+    _done = true;
+    pthread_cond_broadcast(&_work_cond);
+    pthread_mutex_unlock(&_lock);
+
+    for(threads_st i=0; i < _threads.size(); i++)
+      pthread_join(_threads[i], NULL);
+
+    _threads.clear();
+  } // ParserPool::stop
+
+  void ParserPool::parse(jobs_t &jobs) {
+    if (jobs.empty()) return;
+
+    pthread_mutex_lock(&_lock);
+    _jobs = &jobs;
+    _next = 0;
+    _remaining = jobs.size();
+    _generation++;
+    pthread_cond_broadcast(&_work_cond);
+    pthread_mutex_unlock(&_lock);
+
+    // no sense in sitting idle, help out
+    run_jobs(&jobs);
+
+    // wait for the last job and for every thread to let go of the
+    // batch before handing it back to the caller
+    pthread_mutex_lock(&_lock);
+    while(_remaining > 0 || _active > 0)
+      pthread_cond_wait(&_done_cond, &_lock);
+    _jobs = NULL;
+    pthread_mutex_unlock(&_lock);
+  } // ParserPool::parse
+
+  void ParserPool::run_jobs(jobs_t *jobs) {
+    for(;;) {
+      size_t i = __sync_fetch_and_add(&_next, 1);
+      if (i >= jobs->size()) break;
+
+      job_t &job = (*jobs)[i];
+      job.result->parse(job.timestamp);
+
+      if (__sync_sub_and_fetch(&_remaining, 1) == 0) {
+        pthread_mutex_lock(&_lock);
+        pthread_cond_broadcast(&_done_cond);
+        pthread_mutex_unlock(&_lock);
+      } // if
+    } // for
+  } // ParserPool::run_jobs
+
+  void *ParserPool::ParserThread(void *arg) {
+    ParserPool *pool = static_cast<ParserPool *>(arg);
+    unsigned int seen = 0;
+
+    for(;;) {
+      pthread_mutex_lock(&pool->_lock);
+      while(!pool->_done && (pool->_generation == seen || pool->_jobs == NULL))
+        pthread_cond_wait(&pool->_work_cond, &pool->_lock);
+
+      if (pool->_done) {
+        pthread_mutex_unlock(&pool->_lock);
+        break;
+      } // if
+
+      seen = pool->_generation;
+      jobs_t *jobs = pool->_jobs;
+      pool->_active++;
+      pthread_mutex_unlock(&pool->_lock);
+
+      pool->run_jobs(jobs);
+
+      pthread_mutex_lock(&pool->_lock);
+      pool->_active--;
+      pthread_cond_broadcast(&pool->_done_cond);
+      pthread_mutex_unlock(&pool->_lock);
+    } // for
+
+    return NULL;
+  } // ParserPool::ParserThread
+
+} // namespace aprsinject
@@ -0,0 +1,230 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+
+#include <algorithm>
+#include <new>
+#include <cassert>
+#include <iomanip>
+
+#include <unistd.h>
+
+#include <openframe/openframe.h>
+
+#include "DBI.h"
+#include "Preloader.h"
+
+namespace aprsinject {
+  using namespace openframe::loglevel;
+
+/**************************************************************************
+ ** Preloader Class                                                      **
+ **************************************************************************/
+  const size_t Preloader::kDefaultChunk		= 5000;
+  const time_t Preloader::kDefaultSnapshotInterval	= 300;
+
+  Preloader::Preloader(const openframe::LogObject::thread_id_t thread_id,
+                       IdCache *ids,
+                       const std::string &host,
+                       const std::string &user,
+                       const std::string &pass,
+                       const std::string &db,
+                       const size_t chunk) :
+    openframe::LogObject(thread_id),
+    _ids(ids),
+    _host(host),
+    _user(user),
+    _pass(pass),
+    _db(db),
+    _chunk(chunk ? chunk : kDefaultChunk),
+    _preload(true),
+    _snapshot_interval(kDefaultSnapshotInterval),
+    _mapped(NULL),
+    _written(NULL),
+    _started(false),
+    _stop(false),
+    _done(false) {
+
+    assert(_ids != NULL);		// bug
+  } // Preloader::Preloader
+
+  Preloader::~Preloader() {
+    stop();
+    if (_written) delete _written;
+  } // Preloader::~Preloader
+
+  void Preloader::start() {
+    if (_started) return;
+
+    _started = true;
+    pthread_create(&_thread_id, NULL, Preloader::PreloadThread, this);
+  } // Preloader::start
+
+  void Preloader::stop() {
+    if (!_started) return;
+
+    _stop = true;
+    pthread_join(_thread_id, NULL);
+    _started = false;
+  } // Preloader::stop
+
+  void *Preloader::PreloadThread(void *arg) {
+    Preloader *preloader = static_cast<Preloader *>(arg);
+    preloader->run();
+    preloader->_done = true;
+    return NULL;
+  } // Preloader::PreloadThread
+
+  void Preloader::run() {
+    if (_preload) preload();
+    if (_snapshot_path.empty()) return;
+
+    time_t last_snapshot_at = time(NULL);
+    while(!_stop) {
+      sleep(1);
+      if (last_snapshot_at > time(NULL) - _snapshot_interval) continue;
+
+      write_snapshot();
+      last_snapshot_at = time(NULL);
+    } // while
+
+    // one last time so the next start picks up right where we left off
+    write_snapshot();
+  } // Preloader::run
+
+  void Preloader::preload() {
+    DBI *dbi;
+    openframe::Stopwatch sw;
+
+    sw.Start();
+
+    try {
+      dbi = new DBI(thread_id(), _host, _user, _pass, _db);
+      dbi->set_elogger( elogger(), elog_name() );
+      dbi->init();
+    } // try
+    catch(std::bad_alloc &xa) {
+      assert(false);
+    } // catch
+
+    size_t total = 0;
+    for(int i=0; i < IdCache::nsMax && !_stop; i++)
+      total += preload(dbi, static_cast<IdCache::namespaceEnum>(i) );
+
+    delete dbi;
+
+    TLOG(LogNotice, << "Preloaded " << total << " ids in "
+                    << std::fixed << std::setprecision(2) << sw.Time() << "s"
+                    << (_stop ? ", stopped early" : "")
+                    << std::endl);
+  } // Preloader::preload
+
+  size_t Preloader::preload(DBI *dbi, const IdCache::namespaceEnum ns) {
+    static const char *tables[IdCache::nsMax][2] = {
+      { "callsign", "source" },
+      { "object_name", "name" },
+      { "destination", "name" },
+      { "digis", "name" },
+      { "maidenhead", "locator" }
+    };
+
+    openframe::Stopwatch sw;
+    size_t capacity = _ids->capacity(ns);
+    size_t loaded = 0;
+    sqlid_t before = 0;
+    // the snapshot already has everything up to here
+    sqlid_t after = _mapped ? _mapped->max_id(ns) : 0;
+
+    sw.Start();
+
+    // anything past capacity would only push out what we just loaded
+    while(!_stop && loaded < capacity) {
+      size_t limit = std::min(_chunk, capacity - loaded);
+      DBI::idrows_t rows;
+      if (!dbi->getIds(tables[ns][0], tables[ns][1], after, before, limit, rows) ) break;
+
+      for(DBI::idrows_t::iterator itr = rows.begin(); itr != rows.end(); itr++)
+        _ids->store(ns, IdCache::key_for(ns, itr->second), itr->first);
+
+      loaded += rows.size();
+      if (rows.size() < limit) break;
+      before = rows.back().first;
+
+      TLOG(LogInfo, << "Preloading " << IdCache::namespace_to_string(ns)
+                    << " ids, " << loaded << " of at most " << capacity
+                    << std::endl);
+    } // while
+
+    TLOG(LogNotice, << "Preloaded " << loaded << " "
+                    << IdCache::namespace_to_string(ns) << " ids"
+                    << (after ? " newer than the snapshot" : "") << " in "
+                    << std::fixed << std::setprecision(2) << sw.Time() << "s"
+                    << std::endl);
+
+    return loaded;
+  } // Preloader::preload
+
+  void Preloader::write_snapshot() {
+    openframe::Stopwatch sw;
+    sw.Start();
+
+    // the cache only holds so much, whatever it has let go of since
+    // the last one is still in the last one
+    const IdSnapshot *last = _written ? _written : _mapped;
+    IdSnapshot::entries_t entries[IdCache::nsMax];
+    for(int i=0; i < IdCache::nsMax; i++) {
+      IdCache::namespaceEnum ns = static_cast<IdCache::namespaceEnum>(i);
+      IdCache::pairs_t pairs;
+      _ids->dump(ns, pairs);
+
+      entries[i].reserve( pairs.size() + (last ? last->size(ns) : 0) );
+      for(IdCache::pairs_t::const_iterator itr = pairs.begin(); itr != pairs.end(); itr++) {
+        IdSnapshot::entry_t entry;
+        entry.key = itr->first;
+        entry.id = itr->second;
+        entries[i].push_back(entry);
+      } // for
+      if (last) last->copy(ns, entries[i]);
+    } // for
+
+    std::string error;
+    if (!IdSnapshot::write(_snapshot_path, entries, error)) {
+      TLOG(LogWarn, << "Could not write id snapshot; " << error << std::endl);
+      return;
+    } // if
+
+    IdSnapshot *written = new IdSnapshot();
+    if (!written->open(_snapshot_path)) {
+      TLOG(LogWarn, << "Could not map id snapshot; " << written->last_error() << std::endl);
+      delete written;
+      return;
+    } // if
+
+    if (_written) delete _written;
+    _written = written;
+
+    TLOG(LogInfo, << "Wrote " << _written->size() << " ids to " << _snapshot_path
+                  << " in " << std::fixed << std::setprecision(2) << sw.Time() << "s"
+                  << std::endl);
+  } // Preloader::write_snapshot
+
+} // namespace aprsinject
@@ -0,0 +1,508 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+
+#include <openframe/openframe.h>
+
+#include "RecordCodec.h"
+#include "DBI.h"
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** Packing                                                              **
+ **************************************************************************/
+  // little endian whatever the host is, records are shared between boxes
+  class Packer {
+    public:
+      Packer(std::string &buf) : _buf(buf) { }
+
+      void u8(const unsigned char v) { _buf += static_cast<char>(v); }
+      void u16(const uint16_t v) {
+        u8(v & 0xff);
+        u8(v >> 8);
+      } // u16
+      void u32(const uint32_t v) {
+        for(int i=0; i < 4; i++) u8( (v >> (i * 8)) & 0xff );
+      } // u32
+      void u64(const uint64_t v) {
+        for(int i=0; i < 8; i++) u8( (v >> (i * 8)) & 0xff );
+      } // u64
+      void coord(const double v) { u32( static_cast<uint32_t>( static_cast<int32_t>( floor(v * 1000000.0 + 0.5) ) ) ); }
+      void str(const std::string &v) {
+        size_t length = v.length() > 0xffff ? 0xffff : v.length();
+        u16(length);
+        _buf.append(v.data(), length);
+      } // str
+
+    private:
+      std::string &_buf;
+  }; // class Packer
+
+  class Unpacker {
+    public:
+      Unpacker(const char *data, const size_t length) :
+        _pos(reinterpret_cast<const unsigned char *>(data)),
+        _end(reinterpret_cast<const unsigned char *>(data) + length),
+        _ok(true) { }
+
+      bool ok() const { return _ok; }
+      bool need(const size_t n) {
+        if (_ok && size_t(_end - _pos) < n) _ok = false;
+        return _ok;
+      } // need
+
+      unsigned char u8() { return need(1) ? *_pos++ : 0; }
+      uint16_t u16() {
+        if (!need(2)) return 0;
+        uint16_t v = _pos[0] | (_pos[1] << 8);
+        _pos += 2;
+        return v;
+      } // u16
+      uint32_t u32() {
+        if (!need(4)) return 0;
+        uint32_t v = 0;
+        for(int i=3; i >= 0; i--) v = (v << 8) | _pos[i];
+        _pos += 4;
+        return v;
+      } // u32
+      uint64_t u64() {
+        if (!need(8)) return 0;
+        uint64_t v = 0;
+        for(int i=7; i >= 0; i--) v = (v << 8) | _pos[i];
+        _pos += 8;
+        return v;
+      } // u64
+      double coord() { return static_cast<int32_t>( u32() ) / 1000000.0; }
+      std::string str() {
+        uint16_t length = u16();
+        if (!need(length)) return "";
+        std::string v(reinterpret_cast<const char *>(_pos), length);
+        _pos += length;
+        return v;
+      } // str
+      Slice bytes(const size_t length) {
+        if (!need(length)) return Slice();
+        Slice v(reinterpret_cast<const char *>(_pos), length);
+        _pos += length;
+        return v;
+      } // bytes
+      bool empty() const { return _pos >= _end; }
+
+      // anything newer than us is still readable, we just take the
+      // fields we know about
+      bool header(const RecordCodec::typeEnum type) {
+        if (u8() != RecordCodec::kMagic) _ok = false;
+        if (u8() < 1) _ok = false;
+        if (u8() != type) _ok = false;
+        return _ok;
+      } // header
+
+    private:
+      const unsigned char *_pos;
+      const unsigned char *_end;
+      bool _ok;
+  }; // class Unpacker
+
+  static std::string coord_str(const double v) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.6f", v);
+    return buf;
+  } // coord_str
+
+/**************************************************************************
+ ** RecordCodec Class                                                    **
+ **************************************************************************/
+  const unsigned char RecordCodec::kMagic	= 0x01;
+  const unsigned char RecordCodec::kVersion	= 1;
+
+  RecordCodec::formatEnum RecordCodec::string_to_format(const std::string &format) {
+    return format == "binary" ? formatBinary : formatText;
+  } // RecordCodec::string_to_format
+
+  void RecordCodec::begin_list(std::string &buf, const typeEnum type) const {
+    buf.clear();
+    if (_format == formatText) return;
+
+    Packer p(buf);
+    p.u8(kMagic);
+    p.u8(kVersion);
+    p.u8(type);
+  } // RecordCodec::begin_list
+
+  std::string RecordCodec::encode(const DuplicateEntry &entry) const {
+    std::string buf;
+
+    if (_format == formatText) {
+      openframe::Vars v;
+      v.add("sr", entry.source);
+      v.add("ct", openframe::stringify<time_t>(entry.timestamp) );
+      if (entry.has_position) {
+        v.add("la", coord_str(entry.latitude) );
+        v.add("ln", coord_str(entry.longitude) );
+      } // if
+      v.compile(buf, "");
+      return buf;
+    } // if
+
+    begin_list(buf, typeDuplicate);
+    Packer p(buf);
+    p.str(entry.source);
+    p.u32(entry.timestamp);
+    p.u8(entry.has_position ? 1 : 0);
+    p.coord(entry.latitude);
+    p.coord(entry.longitude);
+    return buf;
+  } // RecordCodec::encode
+
+  bool RecordCodec::decode(const std::string &buf, DuplicateEntry &entry) {
+    if ( !is_binary(Slice(buf.data(), buf.length())) ) {
+      openframe::Vars v(buf);
+      if ( !v.exists("ct") ) return false;
+      entry.source = v["sr"];
+      entry.timestamp = atol( v["ct"].c_str() );
+      entry.has_position = v.exists("la,ln");
+      if (entry.has_position) {
+        entry.latitude = atof( v["la"].c_str() );
+        entry.longitude = atof( v["ln"].c_str() );
+      } // if
+      return true;
+    } // if
+
+    Unpacker u(buf.data(), buf.length());
+    if ( !u.header(typeDuplicate) ) return false;
+    entry.source = u.str();
+    entry.timestamp = u.u32();
+    entry.has_position = u.u8() != 0;
+    entry.latitude = u.coord();
+    entry.longitude = u.coord();
+    return u.ok();
+  } // RecordCodec::decode
+
+  std::string RecordCodec::encode(const PositionEntry &entry) const {
+    std::string buf;
+
+    if (_format == formatText) {
+      openframe::Vars v;
+      v.add("sr", entry.source);
+      v.add("la", coord_str(entry.latitude) );
+      v.add("ln", coord_str(entry.longitude) );
+      v.add("ct", openframe::stringify<time_t>(entry.timestamp) );
+      v.add("cm", entry.comment);
+      v.compile(buf, "");
+      return buf;
+    } // if
+
+    begin_list(buf, typePosition);
+    Packer p(buf);
+    p.str(entry.source);
+    p.coord(entry.latitude);
+    p.coord(entry.longitude);
+    p.u32(entry.timestamp);
+    p.str(entry.comment);
+    return buf;
+  } // RecordCodec::encode
+
+  bool RecordCodec::decode(const std::string &buf, PositionEntry &entry) {
+    if ( !is_binary(Slice(buf.data(), buf.length())) ) {
+      openframe::Vars v(buf);
+      if ( !v.exists("la,ln,ct,cm") ) return false;
+      entry.source = v["sr"];
+      entry.latitude = atof( v["la"].c_str() );
+      entry.longitude = atof( v["ln"].c_str() );
+      entry.timestamp = atol( v["ct"].c_str() );
+      entry.comment = v["cm"];
+      return true;
+    } // if
+
+    Unpacker u(buf.data(), buf.length());
+    if ( !u.header(typePosition) ) return false;
+    entry.source = u.str();
+    entry.latitude = u.coord();
+    entry.longitude = u.coord();
+    entry.timestamp = u.u32();
+    entry.comment = u.str();
+    return u.ok();
+  } // RecordCodec::decode
+
+  std::string RecordCodec::encode(const Icon &icon) const {
+    std::string buf;
+
+    if (_format == formatText) {
+      openframe::Vars v;
+      v.add("id", icon.id);
+      v.add("pa", icon.path);
+      v.add("ic", icon.image);
+      v.add("dir", icon.direction);
+      return v.compile();
+    } // if
+
+    begin_list(buf, typeIcon);
+    Packer p(buf);
+    p.str(icon.id);
+    p.str(icon.path);
+    p.str(icon.image);
+    p.str(icon.direction);
+    return buf;
+  } // RecordCodec::encode
+
+  bool RecordCodec::decode(const std::string &buf, Icon &icon) {
+    if ( !is_binary(Slice(buf.data(), buf.length())) ) {
+      openframe::Vars v(buf);
+      if ( !v.is("id,pa,ic,dir") ) return false;
+      icon.id = v["id"];
+      icon.path = v["pa"];
+      icon.image = v["ic"];
+      icon.direction = v["dir"];
+      return true;
+    } // if
+
+    Unpacker u(buf.data(), buf.length());
+    if ( !u.header(typeIcon) ) return false;
+    icon.id = u.str();
+    icon.path = u.str();
+    icon.image = u.str();
+    icon.direction = u.str();
+    return u.ok();
+  } // RecordCodec::decode
+
+  void RecordCodec::append(std::string &buf, const LastpositionEntry &entry) const {
+    if (_format == formatText) {
+      openframe::Vars v;
+      v.add("id", entry.packet_id);
+      v.add("cid", openframe::stringify<sqlid_t>(entry.callsign_id) );
+      v.add("nid", openframe::stringify<sqlid_t>(entry.name_id) );
+      v.add("sr", entry.source);
+      if (entry.name.length()) v.add("nm", entry.name);
+      v.add("pa", entry.path);
+      if (entry.course.length()) v.add("cr", entry.course);
+      if (entry.speed.length()) v.add("sp", entry.speed);
+      if (entry.altitude.length()) v.add("at", entry.altitude);
+      v.add("st", entry.symbol_table);
+      v.add("sc", entry.symbol_code);
+      if (entry.overlay.length()) v.add("ovr", entry.overlay);
+      v.add("phgr", entry.phg_range);
+      v.add("phgd", entry.phg_directivity);
+      v.add("ic", entry.icon);
+      v.add("la", coord_str(entry.latitude) );
+      v.add("ln", coord_str(entry.longitude) );
+      v.add("ct", openframe::stringify<time_t>(entry.timestamp) );
+      v.add("cm", entry.comment);
+      buf += v.compile();
+      buf += '\n';
+      return;
+    } // if
+
+    std::string body;
+    Packer p(body);
+    // source and time first, they're all a reader needs to decide
+    // whether to keep an entry
+    p.str(entry.source);
+    p.u32(entry.timestamp);
+    p.coord(entry.latitude);
+    p.coord(entry.longitude);
+    p.u64(entry.callsign_id);
+    p.u64(entry.name_id);
+    p.str(entry.packet_id);
+    p.str(entry.name);
+    p.str(entry.path);
+    p.str(entry.course);
+    p.str(entry.speed);
+    p.str(entry.altitude);
+    p.str(entry.symbol_table);
+    p.str(entry.symbol_code);
+    p.str(entry.overlay);
+    p.str(entry.phg_range);
+    p.str(entry.phg_directivity);
+    p.str(entry.icon);
+    p.str(entry.comment);
+
+    Packer(buf).str(body);
+  } // RecordCodec::append
+
+  void RecordCodec::append(std::string &buf, const TrailEntry &entry) const {
+    if (_format == formatText) {
+      openframe::Vars v;
+      v.add("L", coord_str(entry.latitude) );
+      v.add("G", coord_str(entry.longitude) );
+      v.add("T", openframe::stringify<time_t>(entry.timestamp) );
+      buf += v.compile();
+      buf += '\n';
+      return;
+    } // if
+
+    std::string body;
+    Packer p(body);
+    p.u32(entry.timestamp);
+    p.coord(entry.latitude);
+    p.coord(entry.longitude);
+
+    Packer(buf).str(body);
+  } // RecordCodec::append
+
+  void RecordCodec::append(std::string &buf, const typeEnum type, const Slice &entry, const formatEnum format) const {
+    if (format == _format) {
+      if (_format == formatText) {
+        buf.append(entry.data(), entry.length());
+        buf += '\n';
+      } // if
+      else {
+        Packer p(buf);
+        p.u16(entry.length());
+        buf.append(entry.data(), entry.length());
+      } // else
+      return;
+    } // if
+
+    if (type == typeLastpositions) {
+      LastpositionEntry lp;
+      if (RecordListReader::decode(entry, format, lp)) append(buf, lp);
+    } // if
+    else if (type == typeTrail) {
+      TrailEntry te;
+      if (RecordListReader::decode(entry, format, te)) append(buf, te);
+    } // else if
+  } // RecordCodec::append
+
+/**************************************************************************
+ ** RecordListReader Class                                               **
+ **************************************************************************/
+  RecordListReader::RecordListReader(const std::string &buf, const RecordCodec::typeEnum type) :
+    _lines(buf), _pos(buf.data()), _end(buf.data() + buf.length()) {
+
+    _format = RecordCodec::is_binary(Slice(buf.data(), buf.length())) ? RecordCodec::formatBinary : RecordCodec::formatText;
+    if (_format == RecordCodec::formatText) return;
+
+    Unpacker u(buf.data(), buf.length());
+    // not a list we know, treat it as empty
+    _pos = u.header(type) ? _pos + 3 : _end;
+  } // RecordListReader::RecordListReader
+
+  bool RecordListReader::next(Slice &entry) {
+    if (_format == RecordCodec::formatText) return _lines.next(entry);
+
+    Unpacker u(_pos, _end - _pos);
+    uint16_t length = u.u16();
+    entry = u.bytes(length);
+    if (!u.ok()) {
+      _pos = _end;
+      return false;
+    } // if
+
+    _pos = entry.data() + entry.length();
+    return true;
+  } // RecordListReader::next
+
+  bool RecordListReader::peek(const Slice &entry, const RecordCodec::formatEnum format, const RecordCodec::typeEnum type,
+                              std::string &source, time_t &timestamp) {
+    if (format == RecordCodec::formatText) {
+      openframe::Vars v(entry.str());
+      if (type == RecordCodec::typeTrail) {
+        if ( !v.is("L,G,T") ) return false;
+        timestamp = atol( v["T"].c_str() );
+        return true;
+      } // if
+
+      if ( !v.is("sr,ct") ) return false;
+      source = v["sr"];
+      timestamp = atol( v["ct"].c_str() );
+      return true;
+    } // if
+
+    Unpacker u(entry.data(), entry.length());
+    if (type != RecordCodec::typeTrail) source = u.str();
+    timestamp = u.u32();
+    return u.ok();
+  } // RecordListReader::peek
+
+  bool RecordListReader::decode(const Slice &entry, const RecordCodec::formatEnum format, LastpositionEntry &ret) {
+    if (format == RecordCodec::formatText) {
+      openframe::Vars v(entry.str());
+      if ( !v.is("sr,ct") ) return false;
+      ret.packet_id = v["id"];
+      ret.callsign_id = PacketRecord::to_id(v["cid"]);
+      ret.name_id = PacketRecord::to_id(v["nid"]);
+      ret.source = v["sr"];
+      ret.name = v.exists("nm") ? v["nm"] : "";
+      ret.path = v["pa"];
+      ret.course = v.exists("cr") ? v["cr"] : "";
+      ret.speed = v.exists("sp") ? v["sp"] : "";
+      ret.altitude = v.exists("at") ? v["at"] : "";
+      ret.symbol_table = v["st"];
+      ret.symbol_code = v["sc"];
+      ret.overlay = v.exists("ovr") ? v["ovr"] : "";
+      ret.phg_range = v["phgr"];
+      ret.phg_directivity = v["phgd"];
+      ret.icon = v["ic"];
+      ret.latitude = atof( v["la"].c_str() );
+      ret.longitude = atof( v["ln"].c_str() );
+      ret.timestamp = atol( v["ct"].c_str() );
+      ret.comment = v["cm"];
+      return true;
+    } // if
+
+    Unpacker u(entry.data(), entry.length());
+    ret.source = u.str();
+    ret.timestamp = u.u32();
+    ret.latitude = u.coord();
+    ret.longitude = u.coord();
+    ret.callsign_id = u.u64();
+    ret.name_id = u.u64();
+    ret.packet_id = u.str();
+    ret.name = u.str();
+    ret.path = u.str();
+    ret.course = u.str();
+    ret.speed = u.str();
+    ret.altitude = u.str();
+    ret.symbol_table = u.str();
+    ret.symbol_code = u.str();
+    ret.overlay = u.str();
+    ret.phg_range = u.str();
+    ret.phg_directivity = u.str();
+    ret.icon = u.str();
+    ret.comment = u.str();
+    return u.ok();
+  } // RecordListReader::decode
+
+  bool RecordListReader::decode(const Slice &entry, const RecordCodec::formatEnum format, TrailEntry &ret) {
+    if (format == RecordCodec::formatText) {
+      openframe::Vars v(entry.str());
+      if ( !v.is("L,G,T") ) return false;
+      ret.latitude = atof( v["L"].c_str() );
+      ret.longitude = atof( v["G"].c_str() );
+      ret.timestamp = atol( v["T"].c_str() );
+      return true;
+    } // if
+
+    Unpacker u(entry.data(), entry.length());
+    ret.timestamp = u.u32();
+    ret.latitude = u.coord();
+    ret.longitude = u.coord();
+    return u.ok();
+  } // RecordListReader::decode
+
+} // namespace aprsinject
@@ -0,0 +1,143 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+
+#include <cassert>
+
+#include <sys/time.h>
+
+#include <openframe/openframe.h>
+#include <aprs/aprs.h>
+
+#include "ResultLanes.h"
+#include "Worker.h"
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** ResultLanes Class                                                    **
+ **************************************************************************/
+  ResultLanes::ResultLanes() : _size(0), _turn(lanePosition) {
+    reset_stats();
+  } // ResultLanes::ResultLanes
+
+  ResultLanes::~ResultLanes() {
+    // the owner drains us, we never own results
+  } // ResultLanes::~ResultLanes
+
+  ResultLanes::laneEnum ResultLanes::lane_for(const Result *result) {
+    switch( result->record().type ) {
+      case aprs::APRS::APRS_PACKET_MESSAGE:
+        return laneMessage;
+      case aprs::APRS::APRS_PACKET_POSITION:
+        return lanePosition;
+      default:
+        break;
+    } // switch
+
+    return laneBulk;
+  } // ResultLanes::lane_for
+
+  const char *ResultLanes::lane_name(const laneEnum lane) {
+    switch(lane) {
+      case laneMessage:
+        return "message";
+      case lanePosition:
+        return "position";
+      default:
+        break;
+    } // switch
+
+    return "bulk";
+  } // ResultLanes::lane_name
+
+  void ResultLanes::push_back(Result *result) {
+    assert(result != NULL);		// bug
+
+    entry_t entry;
+    entry.result = result;
+    entry.queued_at = now();
+    _lanes[ lane_for(result) ].push_back(entry);
+    _size++;
+  } // ResultLanes::push_back
+
+  void ResultLanes::push_front(Result *result) {
+    assert(result != NULL);		// bug
+
+    entry_t entry;
+    entry.result = result;
+    entry.queued_at = now();
+    _lanes[ lane_for(result) ].push_front(entry);
+    _size++;
+  } // ResultLanes::push_front
+
+  ResultLanes::laneEnum ResultLanes::next_lane() {
+    if (!_lanes[laneMessage].empty()) return laneMessage;
+
+    // the rest take turns, skip over anything empty
+    for(int i=0; i < numLanes; i++) {
+      laneEnum lane = static_cast<laneEnum>( (_turn + i) % numLanes );
+      if (lane == laneMessage) continue;
+      if (!_lanes[lane].empty()) return lane;
+    } // for
+
+    assert(false);			// bug, empty() should have been checked
+    return laneBulk;
+  } // ResultLanes::next_lane
+
+  Result *ResultLanes::front() {
+    assert(_size > 0);		// bug
+    return _lanes[ next_lane() ].front().result;
+  } // ResultLanes::front
+
+  void ResultLanes::pop_front() {
+    assert(_size > 0);		// bug
+
+    laneEnum lane = next_lane();
+    double wait = now() - _lanes[lane].front().queued_at;
+    _lanes[lane].pop_front();
+    _size--;
+
+    lane_stats_t &stats = _stats[lane];
+    stats.count++;
+    stats.wait += wait;
+    if (wait > stats.wait_max) stats.wait_max = wait;
+
+    if (lane != laneMessage)
+      _turn = static_cast<laneEnum>( (lane + 1) % numLanes );
+  } // ResultLanes::pop_front
+
+  void ResultLanes::reset_stats() {
+    for(int i=0; i < numLanes; i++) {
+      _stats[i].count = 0;
+      _stats[i].wait = 0.0;
+      _stats[i].wait_max = 0.0;
+    } // for
+  } // ResultLanes::reset_stats
+
+  double ResultLanes::now() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + (tv.tv_usec / 1000000.0);
+  } // ResultLanes::now
+
+} // namespace aprsinject
@@ -0,0 +1,82 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+#include <new>
+#include <cassert>
+
+#include <openframe/openframe.h>
+#include <aprs/aprs.h>
+
+#include "ResultPool.h"
+#include "Worker.h"
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** ResultPool Class                                                     **
+ **************************************************************************/
+  const size_t ResultPool::kDefaultSize		= 8192;
+
+  ResultPool::ResultPool(const size_t size) : _free(size) {
+  } // ResultPool::ResultPool
+
+  ResultPool::~ResultPool() {
+    // _free releases whatever is left on its way out
+  } // ResultPool::~ResultPool
+
+  Result *ResultPool::acquire(const Slice &packet, const time_t now, bool &allocated) {
+    Result *result;
+
+    allocated = !_free.pop(result);
+    if (allocated) {
+      try {
+        result = new Result(packet, now);
+      } // try
+      catch(std::bad_alloc &xa) {
+        assert(false);
+      } // catch
+    } // if
+    else
+      result->reset(packet, now);
+
+    result->_pool = this;
+    return result;
+  } // ResultPool::acquire
+
+  void ResultPool::recycle(Result *result) {
+    assert(result != NULL);		// bug
+
+    result->clear();
+
+    // pool is full, let it go
+    if ( !_free.push(result) ) result->release();
+  } // ResultPool::recycle
+
+  aprs::APRS *ResultPool::create_aprs(const std::string &packet, const time_t timestamp) {
+    return new aprs::APRS(packet, timestamp);
+  } // ResultPool::create_aprs
+
+  void ResultPool::destroy_aprs(aprs::APRS *aprs) {
+    delete aprs;
+  } // ResultPool::destroy_aprs
+
+} // namespace aprsinject
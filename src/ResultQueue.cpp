@@ -0,0 +1,138 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+#include <new>
+#include <cassert>
+
+#include <stdint.h>
+
+#include <openframe/openframe.h>
+
+#include "ResultQueue.h"
+#include "EventLoop.h"
+#include "Worker.h"
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** ResultQueue Class                                                    **
+ **************************************************************************/
+  const size_t ResultQueue::kDefaultSize		= 4096;
+
+  ResultQueue::ResultQueue(const size_t size) {
+    // round up to a power of two so we can mask instead of mod
+    size_t capacity = 2;
+    while(capacity < size) capacity <<= 1;
+
+    try {
+      _buffer = new cell_t[capacity];
+    } // try
+    catch(std::bad_alloc &xa) {
+      assert(false);
+    } // catch
+
+    _mask = capacity - 1;
+    for(size_t i=0; i < capacity; i++) {
+      _buffer[i].sequence = i;
+      _buffer[i].result = NULL;
+    } // for
+
+    _enqueue_pos = 0;
+    _dequeue_pos = 0;
+    _notify = NULL;
+  } // ResultQueue::ResultQueue
+
+  ResultQueue::~ResultQueue() {
+    Result *result;
+    while( pop(result) )
+      result->release();
+
+    delete [] _buffer;
+  } // ResultQueue::~ResultQueue
+
+  bool ResultQueue::push(Result *result) {
+    cell_t *cell;
+    size_t pos = _enqueue_pos;
+
+    for(;;) {
+      cell = &_buffer[pos & _mask];
+      size_t seq = cell->sequence;
+      intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+
+      if (dif == 0) {
+        if (__sync_bool_compare_and_swap(&_enqueue_pos, pos, pos + 1)) break;
+        pos = _enqueue_pos;
+      } // if
+      else if (dif < 0)
+        return false;		// full
+      else
+        pos = _enqueue_pos;
+    } // for
+
+    cell->result = result;
+    // publish the result before the consumer can see the sequence
+    __sync_synchronize();
+    cell->sequence = pos + 1;
+
+    EventLoop *notify = _notify;
+    if (notify) notify->wake();
+
+    return true;
+  } // ResultQueue::push
+
+  bool ResultQueue::pop(Result *&result) {
+    cell_t *cell;
+    size_t pos = _dequeue_pos;
+
+    for(;;) {
+      cell = &_buffer[pos & _mask];
+      size_t seq = cell->sequence;
+      intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+
+      if (dif == 0) {
+        if (__sync_bool_compare_and_swap(&_dequeue_pos, pos, pos + 1)) break;
+        pos = _dequeue_pos;
+      } // if
+      else if (dif < 0)
+        return false;		// empty
+      else
+        pos = _dequeue_pos;
+    } // for
+
+    result = cell->result;
+    cell->result = NULL;
+    // hand the cell back to producers one lap ahead
+    __sync_synchronize();
+    cell->sequence = pos + _mask + 1;
+
+    return true;
+  } // ResultQueue::pop
+
+  size_t ResultQueue::size() const {
+    size_t enqueue_pos = _enqueue_pos;
+    size_t dequeue_pos = _dequeue_pos;
+
+    // both cursors move independently, this is only a snapshot
+    return enqueue_pos > dequeue_pos ? enqueue_pos - dequeue_pos : 0;
+  } // ResultQueue::size
+
+} // namespace aprsinject
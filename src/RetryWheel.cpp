@@ -0,0 +1,108 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+#include <cassert>
+
+#include <openframe/openframe.h>
+
+#include "RetryWheel.h"
+#include "Worker.h"
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** RetryWheel Class                                                     **
+ **************************************************************************/
+  const size_t RetryWheel::kDefaultSlots		= 64;
+
+  RetryWheel::RetryWheel(const size_t slots) : _slots(slots) {
+    assert(slots > 0);
+    _current = 0;
+    _last_tick = time(NULL);
+    _size = 0;
+  } // RetryWheel::RetryWheel
+
+  RetryWheel::~RetryWheel() {
+    for(slots_st i=0; i < _slots.size(); i++) {
+      for(slot_itr itr = _slots[i].begin(); itr != _slots[i].end(); itr++)
+        itr->result->release();
+    } // for
+  } // RetryWheel::~RetryWheel
+
+  void RetryWheel::schedule(Result *result, const time_t delay) {
+    assert(result != NULL);
+
+    size_t ticks = delay < 1 ? 1 : delay;
+    entry_t entry;
+    entry.result = result;
+    // the slot comes around every _slots.size() ticks, count the
+    // laps it has to wait out first
+    entry.rounds = (ticks - 1) / _slots.size();
+
+    _slots[ (_current + ticks) % _slots.size() ].push_back(entry);
+    _size++;
+  } // RetryWheel::schedule
+
+  size_t RetryWheel::expire(results_t &ready, const time_t now) {
+    size_t num_expired = 0;
+
+    // after a long stall turn the wheel at most one full revolution
+    // per call, any further catch up happens on the next calls
+    for(slots_st i=0; _last_tick < now && i < _slots.size(); i++) {
+      _last_tick++;
+      _current = (_current + 1) % _slots.size();
+
+      slot_t &slot = _slots[_current];
+      for(slot_itr itr = slot.begin(); itr != slot.end();) {
+        if (itr->rounds > 0) {
+          itr->rounds--;
+          itr++;
+          continue;
+        } // if
+
+        ready.push_back(itr->result);
+        slot.erase(itr++);
+        _size--;
+        num_expired++;
+      } // for
+    } // for
+
+    return num_expired;
+  } // RetryWheel::expire
+
+  size_t RetryWheel::expire_all(results_t &ready) {
+    size_t num_expired = 0;
+
+    // oldest slot first, that's the order they'd have come due in
+    for(slots_st i=1; i <= _slots.size(); i++) {
+      slot_t &slot = _slots[ (_current + i) % _slots.size() ];
+      for(slot_itr itr = slot.begin(); itr != slot.end(); itr++)
+        ready.push_back(itr->result);
+      num_expired += slot.size();
+      slot.clear();
+    } // for
+
+    _size = 0;
+    return num_expired;
+  } // RetryWheel::expire_all
+
+} // namespace aprsinject
@@ -0,0 +1,83 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+
+#include <new>
+#include <cassert>
+
+#include <ctype.h>
+
+#include <openframe/openframe.h>
+
+#include "ShardRouter.h"
+#include "Worker.h"
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** ShardRouter Class                                                    **
+ **************************************************************************/
+  ShardRouter::ShardRouter(const size_t num_shards, const size_t queue_size) {
+    assert(num_shards > 0);
+
+    for(size_t i=0; i < num_shards; i++) {
+      try {
+        _shards.push_back( new ResultQueue(queue_size) );
+      } // try
+      catch(std::bad_alloc &xa) {
+        assert(false);
+      } // catch
+    } // for
+  } // ShardRouter::ShardRouter
+
+  ShardRouter::~ShardRouter() {
+    for(shards_st i=0; i < _shards.size(); i++)
+      delete _shards[i];
+  } // ShardRouter::~ShardRouter
+
+  bool ShardRouter::push(Result *result) {
+    assert(result != NULL);		// bug
+    return _shards[ shard_for(result->record().source) ]->push(result);
+  } // ShardRouter::push
+
+  size_t ShardRouter::shard_for(const std::string &source) const {
+    return hash(source) % _shards.size();
+  } // ShardRouter::shard_for
+
+  size_t ShardRouter::size() const {
+    size_t ret = 0;
+    for(shards_st i=0; i < _shards.size(); i++)
+      ret += _shards[i]->size();
+    return ret;
+  } // ShardRouter::size
+
+  // FNV-1a, callsigns come in mixed case so fold them while hashing
+  unsigned int ShardRouter::hash(const std::string &source) {
+    unsigned int h = 2166136261U;
+    for(std::string::size_type i=0; i < source.length(); i++) {
+      h ^= static_cast<unsigned char>( toupper(source[i]) );
+      h *= 16777619U;
+    } // for
+    return h;
+  } // ShardRouter::hash
+
+} // namespace aprsinject
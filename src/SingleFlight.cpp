@@ -0,0 +1,131 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+
+
+#include <new>
+#include <cassert>
+#include <cerrno>
+
+#include <sys/time.h>
+
+#include <openframe/openframe.h>
+
+#include "SingleFlight.h"
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** SingleFlight Class                                                   **
+ **************************************************************************/
+  const time_t SingleFlight::kDefaultWait		= 1000;
+  const size_t SingleFlight::kDefaultStripes		= 16;
+
+  SingleFlight::SingleFlight(const time_t wait_ms, const size_t num_stripes) :
+    _wait(wait_ms),
+    _num_stripes(num_stripes ? num_stripes : kDefaultStripes) {
+
+    try {
+      _stripes = new stripe_t[_num_stripes];
+    } // try
+    catch(std::bad_alloc &xa) {
+      assert(false);
+    } // catch
+
+    for(size_t i=0; i < _num_stripes; i++) {
+      pthread_mutex_init(&_stripes[i].lock, NULL);
+      pthread_cond_init(&_stripes[i].landed, NULL);
+      _stripes[i].sequence = 0;
+    } // for
+  } // SingleFlight::SingleFlight
+
+  SingleFlight::~SingleFlight() {
+    for(size_t i=0; i < _num_stripes; i++) {
+      pthread_cond_destroy(&_stripes[i].landed);
+      pthread_mutex_destroy(&_stripes[i].lock);
+    } // for
+
+    delete [] _stripes;
+  } // SingleFlight::~SingleFlight
+
+  SingleFlight::flightEnum SingleFlight::join(const IdCache::namespaceEnum ns, const IdCache::key_t key) {
+    stripe_t &stripe = stripe_for(key);
+    flight_key_t fkey(ns, key);
+
+    pthread_mutex_lock(&stripe.lock);
+    flights_itr itr = stripe.flights.find(fkey);
+    if (itr == stripe.flights.end()) {
+      stripe.flights[fkey] = ++stripe.sequence;
+      pthread_mutex_unlock(&stripe.lock);
+      return flightLeader;
+    } // if
+
+    if (!_wait) {
+      pthread_mutex_unlock(&stripe.lock);
+      return flightBusy;
+    } // if
+
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    long usec = tv.tv_usec + (_wait % 1000) * 1000;
+    struct timespec until;
+    until.tv_sec = tv.tv_sec + (_wait / 1000) + (usec / 1000000);
+    until.tv_nsec = (usec % 1000000) * 1000;
+
+    uint64_t sequence = itr->second;
+    flightEnum ret = flightJoined;
+    while(true) {
+      itr = stripe.flights.find(fkey);
+      if (itr == stripe.flights.end() || itr->second != sequence) break;
+
+      if (pthread_cond_timedwait(&stripe.landed, &stripe.lock, &until) == ETIMEDOUT) {
+        // it may have landed right as we gave up
+        itr = stripe.flights.find(fkey);
+        if (itr != stripe.flights.end() && itr->second == sequence) ret = flightBusy;
+        break;
+      } // if
+    } // while
+    pthread_mutex_unlock(&stripe.lock);
+
+    return ret;
+  } // SingleFlight::join
+
+  void SingleFlight::land(const IdCache::namespaceEnum ns, const IdCache::key_t key) {
+    stripe_t &stripe = stripe_for(key);
+
+    pthread_mutex_lock(&stripe.lock);
+    stripe.flights.erase( flight_key_t(ns, key) );
+    pthread_cond_broadcast(&stripe.landed);
+    pthread_mutex_unlock(&stripe.lock);
+  } // SingleFlight::land
+
+  size_t SingleFlight::size() const {
+    size_t ret = 0;
+    for(size_t i=0; i < _num_stripes; i++) {
+      pthread_mutex_lock(&_stripes[i].lock);
+      ret += _stripes[i].flights.size();
+      pthread_mutex_unlock(&_stripes[i].lock);
+    } // for
+
+    return ret;
+  } // SingleFlight::size
+} // namespace aprsinject
@@ -0,0 +1,111 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+
+#include <new>
+#include <cassert>
+
+#include <openframe/openframe.h>
+
+#include "StationTable.h"
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** StationTable Class                                                   **
+ **************************************************************************/
+  const time_t StationTable::kDefaultExpire		= 3600;
+  const size_t StationTable::kDefaultStripes		= 64;
+  const time_t StationTable::kSweepInterval		= 60;
+
+  StationTable::StationTable(const time_t expire, const size_t num_stripes) :
+    _expire(expire), _num_stripes(num_stripes ? num_stripes : kDefaultStripes) {
+
+    try {
+      _stripes = new stripe_t[_num_stripes];
+    } // try
+    catch(std::bad_alloc &xa) {
+      assert(false);
+    } // catch
+
+    for(size_t i=0; i < _num_stripes; i++) {
+      pthread_mutex_init(&_stripes[i].lock, NULL);
+      _stripes[i].last_sweep = time(NULL);
+    } // for
+  } // StationTable::StationTable
+
+  StationTable::~StationTable() {
+    for(size_t i=0; i < _num_stripes; i++)
+      pthread_mutex_destroy(&_stripes[i].lock);
+
+    delete [] _stripes;
+  } // StationTable::~StationTable
+
+  void StationTable::sweep(stripe_t &stripe, const time_t now) {
+    if (stripe.last_sweep > now - kSweepInterval) return;
+
+    stations_itr itr = stripe.stations.begin();
+    while(itr != stripe.stations.end()) {
+      if (itr->second.stored <= now - _expire)
+        stripe.stations.erase(itr++);
+      else
+        itr++;
+    } // while
+
+    stripe.last_sweep = now;
+  } // StationTable::sweep
+
+  bool StationTable::find(const key_t key, station_t &ret) {
+    stripe_t &stripe = stripe_for(key);
+
+    pthread_mutex_lock(&stripe.lock);
+    stations_itr itr = stripe.stations.find(key);
+    bool found = itr != stripe.stations.end();
+    if (found) ret = itr->second.station;
+    pthread_mutex_unlock(&stripe.lock);
+
+    return found;
+  } // StationTable::find
+
+  void StationTable::store(const key_t key, const station_t &station, const time_t now) {
+    stripe_t &stripe = stripe_for(key);
+
+    pthread_mutex_lock(&stripe.lock);
+    sweep(stripe, now);
+    entry_t &entry = stripe.stations[key];
+    entry.station = station;
+    entry.stored = now;
+    pthread_mutex_unlock(&stripe.lock);
+  } // StationTable::store
+
+  size_t StationTable::size() const {
+    size_t ret = 0;
+    for(size_t i=0; i < _num_stripes; i++) {
+      pthread_mutex_lock(&_stripes[i].lock);
+      ret += _stripes[i].stations.size();
+      pthread_mutex_unlock(&_stripes[i].lock);
+    } // for
+
+    return ret;
+  } // StationTable::size
+
+} // namespace aprsinject
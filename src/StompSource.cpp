@@ -0,0 +1,179 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+
+#include <cassert>
+
+#include <unistd.h>
+
+#include <openframe/openframe.h>
+#include <stomp/StompFrame.h>
+#include <stomp/Stomp.h>
+
+#include "StompSource.h"
+
+namespace aprsinject {
+
+/**************************************************************************
+ ** StompSource Class                                                    **
+ **************************************************************************/
+  const char *StompSource::kAckClient			= "client";
+  const char *StompSource::kAckClientIndividual		= "client-individual";
+  const char *StompSource::kSubscribeReceipt		= "aprsinject-subscribe";
+  const time_t StompSource::kSubscribeTimeout		= 5;
+
+  StompSource::StompSource(stomp::Stomp *stomp, const std::string &dest, const std::string &ack) :
+    _stomp(stomp), _dest(dest), _ack(ack) {
+    assert(stomp != NULL);		// bug
+  } // StompSource::StompSource
+
+  StompSource::~StompSource() {
+    // the worker owns the connection
+    clear_early();
+  } // StompSource::~StompSource
+
+  void StompSource::clear_early() {
+    while(!_early.empty()) {
+      _early.front()->release();
+      _early.pop_front();
+    } // while
+  } // StompSource::clear_early
+
+  bool StompSource::is_usable(stomp::StompFrame *frame) {
+    return frame->is_command(stomp::StompFrame::commandMessage)
+           && frame->is_header("message-id");
+  } // StompSource::is_usable
+
+  // Stomp::subscribe() leaves the ack mode up to the library so the
+  // SUBSCRIBE goes out by hand.  Nothing says send_frame() notices a
+  // dead connection so we're only connected once the broker has
+  // answered with our receipt.
+  bool StompSource::open() {
+    // anything held back belongs to the last connection
+    clear_early();
+    _error.clear();
+
+    stomp::StompFrame *frame = new stomp::StompFrame("SUBSCRIBE", "");
+    frame->add_header("destination", _dest);
+    frame->add_header("id", "1");
+    frame->add_header("ack", _ack);
+    frame->add_header("receipt", kSubscribeReceipt);
+
+    try {
+      _stomp->send_frame(frame);
+    } // try
+    catch(stomp::Stomp_Exception &ex) {
+      _error = ex.message();
+    } // catch
+    frame->release();
+    if (!_error.empty()) return false;
+
+    time_t started = time(NULL);
+    while(time(NULL) - started < kSubscribeTimeout) {
+      bool ok = false;
+      try {
+        ok = _stomp->next_frame(frame);
+      } // try
+      catch(stomp::Stomp_Exception &ex) {
+        _error = ex.message();
+        return false;
+      } // catch
+
+      if (!ok) {
+        usleep(10000);
+        continue;
+      } // if
+
+      if (frame->is_header("receipt-id")
+          && frame->get_header("receipt-id") == kSubscribeReceipt) {
+        frame->release();
+        return true;
+      } // if
+
+      // the broker can start delivering before the receipt shows up
+      if (is_usable(frame)) {
+        _early.push_back(frame);
+        continue;
+      } // if
+
+      // ERROR frames carry the reason in message
+      if (frame->is_header("message"))
+        _error = "subscribe to " + _dest + " failed; " + frame->get_header("message");
+      frame->release();
+      if (!_error.empty()) return false;
+    } // while
+
+    _error = "no receipt for subscribe to " + _dest;
+    return false;
+  } // StompSource::open
+
+  bool StompSource::next(InputBatch &batch) {
+    stomp::StompFrame *frame;
+
+    if (!_early.empty()) {
+      frame = _early.front();
+      _early.pop_front();
+    } // if
+    else {
+      bool ok = false;
+      try {
+        ok = _stomp->next_frame(frame);
+      } // try
+      catch(stomp::Stomp_Exception &ex) {
+        throw InputSource_Exception(ex.message());
+      } // catch
+
+      if (!ok) return false;
+    } // else
+
+    if (!is_usable(frame)) {
+      frame->release();
+      return false;
+    } // if
+
+    batch.id = frame->get_header("message-id");
+    batch.body = Slice(frame->body().data(), frame->body().length());
+    batch.handle = frame;
+    return true;
+  } // StompSource::next
+
+  void StompSource::release(InputBatch &batch) {
+    assert(batch.handle != NULL);	// bug
+    static_cast<stomp::StompFrame *>(batch.handle)->release();
+    batch.handle = NULL;
+  } // StompSource::release
+
+  bool StompSource::ack(const std::string &id) {
+    return _stomp->ack(id, "1");
+  } // StompSource::ack
+
+  std::string StompSource::describe() {
+    return _stomp->connected_to();
+  } // StompSource::describe
+
+  std::string StompSource::last_error() {
+    std::string ret = _stomp->last_error();
+    if (!_error.empty()) ret = _error;
+    return ret;
+  } // StompSource::last_error
+
+} // namespace aprsinject
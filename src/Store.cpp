@@ -42,6 +42,7 @@
 #include "DBI.h"
 #include "MemcachedController.h"
 #include "Store.h"
+#include "KeyHash.h"
 
 namespace aprsinject {
   using namespace openframe::loglevel;
@@ -50,6 +51,7 @@ namespace aprsinject {
  ** Store Class                                                         **
  **************************************************************************/
   const time_t Store::kDefaultReportInterval			= 3600;
+  const int Store::kLastpositionsRetries			= 3;
 
   Store::Store(const openframe::LogObject::thread_id_t thread_id,
                const std::string &host,
@@ -78,11 +80,17 @@ namespace aprsinject {
 
     _dbi = NULL;
     _memcached = NULL;
+    _ids = NULL;
+    _own_ids = false;
+    _flights = NULL;
+    _own_flights = false;
     _profile = NULL;
   } // Store::Store
 
   Store::~Store() {
     if (_memcached) delete _memcached;
+    if (_own_ids) delete _ids;
+    if (_own_flights) delete _flights;
     if (_dbi) delete _dbi;
     if (_profile) delete _profile;
   } // Store::~Store
@@ -100,6 +108,16 @@ namespace aprsinject {
     _memcached = new MemcachedController(_memcached_host);
     _memcached->expire(_expire_interval);
 
+    if (!_ids) {
+      _ids = new IdCache();
+      _own_ids = true;
+    } // if
+
+    if (!_flights) {
+      _flights = new SingleFlight();
+      _own_flights = true;
+    } // if
+
     _profile = new openframe::Stopwatch();
     _profile->add("memcached.callsign", 300);
     _profile->add("memcached.icon", 300);
@@ -110,6 +128,8 @@ namespace aprsinject {
     _profile->add("memcached.position", 300);
     _profile->add("memcached.locatorseen", 300);
     _profile->add("memcached.positions", 300);
+    _profile->add("memcached.batch", 300);
+    _profile->add("sql.batch", 300);
     _profile->add("sql.insert.path", 300);
     _profile->add("sql.insert.packet", 300);
     _profile->add("sql.insert.position", 300);
@@ -136,6 +156,10 @@ namespace aprsinject {
     memset(&stats.cache_positions, 0, sizeof(memcache_stats_t) );
     memset(&stats.cache_position, 0, sizeof(memcache_stats_t) );
     memset(&stats.cache_locatorseen, 0, sizeof(memcache_stats_t) );
+    memset(&stats.cache_lastpositions, 0, sizeof(memcache_stats_t) );
+    memset(&stats.cache_ids, 0, sizeof(stats.cache_ids) );
+    memset(&stats.batch_ids, 0, sizeof(batch_stats_t) );
+    memset(&stats.flight_ids, 0, sizeof(stats.flight_ids) );
 
     memset(&stats.sql_store, 0, sizeof(sql_stats_t) );
     memset(&stats.sql_callsign, 0, sizeof(sql_stats_t) );
@@ -231,6 +255,7 @@ namespace aprsinject {
     describe_root_stat("store.num.cache.duplicates.tries", "store/cache/duplicates/num tries - duplicates", openstats::graphTypeCounter, openstats::dataTypeInt);
     describe_root_stat("store.num.cache.duplicates.stored", "store/cache/duplicates/num stored - duplicates", openstats::graphTypeCounter, openstats::dataTypeInt);
     describe_root_stat("store.num.cache.duplicates.hitrate", "store/cache/duplicates/num hitrate - duplicates", openstats::graphTypeGauge, openstats::dataTypeFloat);
+    describe_root_stat("store.num.cache.lastpositions.conflicts", "store/cache/lastpositions/num conflicts - lastpositions", openstats::graphTypeCounter, openstats::dataTypeInt);
 
     describe_root_stat("store.num.cache.locator.stored", "store/cache/locator/num stored - locator seen", openstats::graphTypeCounter, openstats::dataTypeInt);
     describe_root_stat("store.num.cache.locator.time.put", "store/cache/locator/time - put locator seen microseconds", openstats::graphTypeGauge, openstats::dataTypeInt);
@@ -247,6 +272,26 @@ namespace aprsinject {
     describe_root_stat("store.num.cache.position.stored", "store/cache/position/num stored - position", openstats::graphTypeCounter, openstats::dataTypeInt);
     describe_root_stat("store.num.cache.position.hitrate", "store/cache/position/num hitrate - position", openstats::graphTypeGauge, openstats::dataTypeFloat);
 
+    describe_root_stat("store.num.batch.names", "store/batch/num names", openstats::graphTypeCounter, openstats::dataTypeInt);
+    describe_root_stat("store.num.batch.cached", "store/batch/num cached", openstats::graphTypeCounter, openstats::dataTypeInt);
+    describe_root_stat("store.num.batch.memcached", "store/batch/num memcached", openstats::graphTypeCounter, openstats::dataTypeInt);
+    describe_root_stat("store.num.batch.sql", "store/batch/num sql", openstats::graphTypeCounter, openstats::dataTypeInt);
+    describe_root_stat("store.num.batch.inserted", "store/batch/num inserted", openstats::graphTypeCounter, openstats::dataTypeInt);
+
+    for(int i=0; i < IdCache::nsMax; i++) {
+      std::string ns = IdCache::namespace_to_string( static_cast<IdCache::namespaceEnum>(i) );
+      describe_root_stat("store.num.cache."+ns+".l1.hits", "store/cache/"+ns+"/num l1 hits - "+ns, openstats::graphTypeCounter, openstats::dataTypeInt);
+      describe_root_stat("store.num.cache."+ns+".l1.misses", "store/cache/"+ns+"/num l1 misses - "+ns, openstats::graphTypeCounter, openstats::dataTypeInt);
+      describe_root_stat("store.num.cache."+ns+".l1.tries", "store/cache/"+ns+"/num l1 tries - "+ns, openstats::graphTypeCounter, openstats::dataTypeInt);
+      describe_root_stat("store.num.cache."+ns+".l1.stored", "store/cache/"+ns+"/num l1 stored - "+ns, openstats::graphTypeCounter, openstats::dataTypeInt);
+      describe_root_stat("store.num.cache."+ns+".l1.hitrate", "store/cache/"+ns+"/num l1 hitrate - "+ns, openstats::graphTypeGauge, openstats::dataTypeFloat);
+      describe_root_stat("store.num.cache."+ns+".l1.size", "store/cache/"+ns+"/num l1 size - "+ns, openstats::graphTypeGauge, openstats::dataTypeInt);
+      describe_root_stat("store.num.cache."+ns+".l1.bytes", "store/cache/"+ns+"/num l1 bytes - "+ns, openstats::graphTypeGauge, openstats::dataTypeInt);
+      describe_root_stat("store.num.flight."+ns+".leaders", "store/flight/"+ns+"/num leaders - "+ns, openstats::graphTypeCounter, openstats::dataTypeInt);
+      describe_root_stat("store.num.flight."+ns+".coalesced", "store/flight/"+ns+"/num coalesced - "+ns, openstats::graphTypeCounter, openstats::dataTypeInt);
+      describe_root_stat("store.num.flight."+ns+".busy", "store/flight/"+ns+"/num busy - "+ns, openstats::graphTypeCounter, openstats::dataTypeInt);
+    } // for
+
     describe_root_stat("store.num.sql.store.hits", "store/sql/store/num hits - store", openstats::graphTypeCounter, openstats::dataTypeInt);
     describe_root_stat("store.num.sql.store.misses", "store/sql/store/num misses - store", openstats::graphTypeCounter, openstats::dataTypeInt);
     describe_root_stat("store.num.sql.store.tries", "store/sql/store/num tries - store", openstats::graphTypeCounter, openstats::dataTypeInt);
@@ -704,6 +749,7 @@ namespace aprsinject {
     datapoint("store.num.cache.duplicates.hits", _stompstats.cache_duplicates.hits);
     datapoint_float("store.num.cache.duplicates.hitrate", OPENSTATS_PERCENT(_stompstats.cache_duplicates.hits, _stompstats.cache_duplicates.tries) );
     datapoint("store.num.cache.duplicates.stored", _stompstats.cache_duplicates.stored);
+    datapoint("store.num.cache.lastpositions.conflicts", _stompstats.cache_lastpositions.conflicts);
 
     datapoint("store.num.cache.locator.stored", _stompstats.cache_locatorseen.stored);
     datapoint("store.num.cache.locator.time.put", _stompstats.prof_cache_locatorseen.mean);
@@ -714,15 +760,51 @@ namespace aprsinject {
     datapoint_float("store.num.cache.positions.hitrate", OPENSTATS_PERCENT(_stompstats.cache_positions.hits, _stompstats.cache_positions.tries) );
     datapoint("store.num.cache.positions.stored", _stompstats.cache_positions.stored);
 
+    datapoint("store.num.batch.names", _stompstats.batch_ids.names);
+    datapoint("store.num.batch.cached", _stompstats.batch_ids.cached);
+    datapoint("store.num.batch.memcached", _stompstats.batch_ids.memcached);
+    datapoint("store.num.batch.sql", _stompstats.batch_ids.sql);
+    datapoint("store.num.batch.inserted", _stompstats.batch_ids.inserted);
+
+    for(int i=0; i < IdCache::nsMax; i++) {
+      IdCache::namespaceEnum ns = static_cast<IdCache::namespaceEnum>(i);
+      std::string name = std::string("store.num.cache.") + IdCache::namespace_to_string(ns) + ".l1";
+      const memcache_stats_t &l1 = _stompstats.cache_ids[i];
+      datapoint(name+".tries", l1.tries);
+      datapoint(name+".misses", l1.misses);
+      datapoint(name+".hits", l1.hits);
+      datapoint_float(name+".hitrate", OPENSTATS_PERCENT(l1.hits, l1.tries) );
+      datapoint(name+".stored", l1.stored);
+
+      name = std::string("store.num.flight.") + IdCache::namespace_to_string(ns);
+      const flight_stats_t &flight = _stompstats.flight_ids[i];
+      datapoint(name+".leaders", flight.leaders);
+      datapoint(name+".coalesced", flight.coalesced);
+      datapoint(name+".busy", flight.busy);
+    } // for
+
+    // every worker's Store shares the cache, only one of us reports
+    // how big it is
+    if (_ids->claim_report(_stompstats.report_interval)) {
+      for(int i=0; i < IdCache::nsMax; i++) {
+        IdCache::namespaceEnum ns = static_cast<IdCache::namespaceEnum>(i);
+        std::string name = std::string("store.num.cache.") + IdCache::namespace_to_string(ns) + ".l1";
+        datapoint(name+".size", _ids->size(ns) );
+        datapoint(name+".bytes", _ids->memory(ns) );
+      } // for
+    } // if
+
     init_stats(_stompstats);
   } // Store::try_stompstats()
 
   bool Store::getCallsignId(const std::string &source, std::string &ret_id) {
-    int i;
-
     // try and find in memcached
     if (getCallsignIdFromMemcached(source, ret_id)) return true;
 
+    return getIdOnce(IdCache::nsCallsign, source, ret_id, &Store::getCallsignIdFromMemcached, &Store::getCallsignIdFromSql);
+  } // Store::getCallsignId
+
+  bool Store::getCallsignIdFromSql(const std::string &source, std::string &ret_id) {
     // not in memcached find in sql
     _stats.sql_callsign.tries++;
     _stompstats.sql_callsign.tries++;
@@ -735,28 +817,25 @@ namespace aprsinject {
     _stats.sql_callsign.misses++;
     _stompstats.sql_callsign.misses++;
 
-    // try again just in case another thread beat us
-    for(i=0; i < 3; i++) {
-      // not in sql try and create it
-      if (_dbi->insertCallsign(source, ret_id)) {
-        setCallsignIdInMemcached(source, ret_id);
-        _stats.sql_callsign.inserted++;
-        _stompstats.sql_callsign.inserted++;
-        return true;
-      } // if
+    // not in sql try and create it
+    if (_dbi->insertCallsign(source, ret_id)) {
+      setCallsignIdInMemcached(source, ret_id);
+      _stats.sql_callsign.inserted++;
+      _stompstats.sql_callsign.inserted++;
+      return true;
+    } // if
 
-      if (_dbi->getCallsignId(source, ret_id)) {
-        setCallsignIdInMemcached(source, ret_id);
-        return true;
-      } // if
-      sleep(3);
-    } // for
+    // another thread may have beaten us to it
+    if (_dbi->getCallsignId(source, ret_id)) {
+      setCallsignIdInMemcached(source, ret_id);
+      return true;
+    } // if
 
     _stats.sql_callsign.failed++;
     _stompstats.sql_callsign.failed++;
 
     return false;
-  } // Store::getCallsignId
+  } // Store::getCallsignIdFromSql
 
   std::string Store::getDirectionByCourse(const int course) {
       const char *dirs[] = { "north", "east", "south", "west", NULL };
@@ -778,31 +857,23 @@ namespace aprsinject {
                               const std::string &symbol_code,
                               const int course,
                               Icon &icon) {
-    md5wrapper md5;
-    std::string key = md5.getHashFromString(symbol_table + symbol_code);
+    std::string key = KeyHash().update(symbol_table).update(symbol_code).hex();
     std::string buf;
 
     // try and find in memcached
-    if (getIconFromMemcached(key, buf)) {
-      openframe::Vars v(buf);
-      if (v.is("id,pa,ic,dir")) {
-        std::string image = v["ic"];
-        std::stringstream s;
-        s << v["pa"];
-        if (v["dir"] == "Y") {
-          openframe::StringTool::replace(".png", "", image);
-          s << "/compass/" << image << "-" << getDirectionByCourse(course) << ".png";
-        } // if
-        else s << "/" << image;
+    if (getIconFromMemcached(key, buf) && RecordCodec::decode(buf, icon)) {
+      std::string image = icon.image;
+      std::stringstream s;
+      s << icon.path;
+      if (icon.direction == "Y") {
+        openframe::StringTool::replace(".png", "", image);
+        s << "/compass/" << image << "-" << getDirectionByCourse(course) << ".png";
+      } // if
+      else s << "/" << image;
 
-        icon.id = v["id"];
-        icon.path = v["pa"];
-        icon.image = v["ic"];
-        icon.direction = v["dir"];
-        icon.icon = s.str();
+      icon.icon = s.str();
 
-        return true;
-      } // if
+      return true;
     } // if
 
     // not in memcached find in sql
@@ -826,11 +897,13 @@ namespace aprsinject {
   } // Store::getIconId
 
   bool Store::getNameId(const std::string &name, std::string &ret_id) {
-    int i;
-
     // try and find in memcached
     if (getNameIdFromMemcached(name, ret_id)) return true;
 
+    return getIdOnce(IdCache::nsName, name, ret_id, &Store::getNameIdFromMemcached, &Store::getNameIdFromSql);
+  } // Store::getNameId
+
+  bool Store::getNameIdFromSql(const std::string &name, std::string &ret_id) {
     // not in memcached find in sql
     _stats.sql_name.tries++;
     _stompstats.sql_name.tries++;
@@ -843,35 +916,34 @@ namespace aprsinject {
     _stats.sql_name.misses++;
     _stompstats.sql_name.misses++;
 
-    // try again just in case another thread beat us
-    for(i=0; i < 3; i++) {
-      // not in sql try and create it
-      if (_dbi->insertName(name, ret_id)) {
-        setNameIdInMemcached(name, ret_id);
-        _stats.sql_name.inserted++;
-        _stompstats.sql_name.inserted++;
-        return true;
-      } // if
+    // not in sql try and create it
+    if (_dbi->insertName(name, ret_id)) {
+      setNameIdInMemcached(name, ret_id);
+      _stats.sql_name.inserted++;
+      _stompstats.sql_name.inserted++;
+      return true;
+    } // if
 
-      if (_dbi->getNameId(name, ret_id)) {
-        setNameIdInMemcached(name, ret_id);
-        return true;
-      } // if
-      sleep(3);
-    } // for
+    // another thread may have beaten us to it
+    if (_dbi->getNameId(name, ret_id)) {
+      setNameIdInMemcached(name, ret_id);
+      return true;
+    } // if
 
     _stats.sql_name.failed++;
     _stompstats.sql_name.failed++;
 
     return false;
-  } // Store::getNameId
+  } // Store::getNameIdFromSql
 
   bool Store::getDestId(const std::string &dest, std::string &ret_id) {
-    int i;
-
     // try and find in memcached
     if (getDestIdFromMemcached(dest, ret_id)) return true;
 
+    return getIdOnce(IdCache::nsDest, dest, ret_id, &Store::getDestIdFromMemcached, &Store::getDestIdFromSql);
+  } // Store::getDestId
+
+  bool Store::getDestIdFromSql(const std::string &dest, std::string &ret_id) {
     // not in memcached find in sql
     _stats.sql_dest.tries++;
     _stompstats.sql_dest.tries++;
@@ -884,35 +956,34 @@ namespace aprsinject {
     _stats.sql_dest.misses++;
     _stompstats.sql_dest.misses++;
 
-    // try again just in case another thread beat us
-    for(i=0; i < 3; i++) {
-      // not in sql try and create it
-      if (_dbi->insertDest(dest, ret_id)) {
-        setDestIdInMemcached(dest, ret_id);
-        _stats.sql_dest.inserted++;
-        _stompstats.sql_dest.inserted++;
-        return true;
-      } // if
+    // not in sql try and create it
+    if (_dbi->insertDest(dest, ret_id)) {
+      setDestIdInMemcached(dest, ret_id);
+      _stats.sql_dest.inserted++;
+      _stompstats.sql_dest.inserted++;
+      return true;
+    } // if
 
-      if (_dbi->getDestId(dest, ret_id)) {
-        setDestIdInMemcached(dest, ret_id);
-        return true;
-      } // if
-      sleep(3);
-    } // for
+    // another thread may have beaten us to it
+    if (_dbi->getDestId(dest, ret_id)) {
+      setDestIdInMemcached(dest, ret_id);
+      return true;
+    } // if
 
     _stats.sql_dest.failed++;
     _stompstats.sql_dest.failed++;
 
     return false;
-  } // Store::getDestId
+  } // Store::getDestIdFromSql
 
   bool Store::getDigiId(const std::string &name, std::string &ret_id) {
-    int i;
-
     // try and find in memcached
     if (getDigiIdFromMemcached(name, ret_id)) return true;
 
+    return getIdOnce(IdCache::nsDigi, name, ret_id, &Store::getDigiIdFromMemcached, &Store::getDigiIdFromSql);
+  } // Store::getDigiId
+
+  bool Store::getDigiIdFromSql(const std::string &name, std::string &ret_id) {
     // not in memcached find in sql
     _stats.sql_digi.tries++;
     _stompstats.sql_digi.tries++;
@@ -925,35 +996,34 @@ namespace aprsinject {
     _stats.sql_digi.misses++;
     _stompstats.sql_digi.misses++;
 
-    // try again just in case another thread beat us
-    for(i=0; i < 3; i++) {
-      // not in sql try and create it
-      if (_dbi->insertDigi(name, ret_id)) {
-        setDigiIdInMemcached(name, ret_id);
-        _stats.sql_digi.inserted++;
-        _stompstats.sql_digi.inserted++;
-        return true;
-      } // if
+    // not in sql try and create it
+    if (_dbi->insertDigi(name, ret_id)) {
+      setDigiIdInMemcached(name, ret_id);
+      _stats.sql_digi.inserted++;
+      _stompstats.sql_digi.inserted++;
+      return true;
+    } // if
 
-      if (_dbi->getDigiId(name, ret_id)) {
-        setDigiIdInMemcached(name, ret_id);
-        return true;
-      } // if
-      sleep(3);
-    } // for
+    // another thread may have beaten us to it
+    if (_dbi->getDigiId(name, ret_id)) {
+      setDigiIdInMemcached(name, ret_id);
+      return true;
+    } // if
 
     _stats.sql_digi.failed++;
     _stompstats.sql_digi.failed++;
 
     return false;
-  } // Store::getDigiId
+  } // Store::getDigiIdFromSql
 
   bool Store::getMaidenheadId(const std::string &locator, std::string &ret_id) {
-    int i;
-
     // try and find in memcached
     if (getMaidenheadIdFromMemcached(locator, ret_id)) return true;
 
+    return getIdOnce(IdCache::nsMaidenhead, locator, ret_id, &Store::getMaidenheadIdFromMemcached, &Store::getMaidenheadIdFromSql);
+  } // Store::getMaidenheadId
+
+  bool Store::getMaidenheadIdFromSql(const std::string &locator, std::string &ret_id) {
     // not in memcached find in sql
     _stats.sql_maidenhead.tries++;
     _stompstats.sql_maidenhead.tries++;
@@ -966,51 +1036,81 @@ namespace aprsinject {
     _stats.sql_maidenhead.misses++;
     _stompstats.sql_maidenhead.misses++;
 
-    // try again just in case another thread beat us
-    for(i=0; i < 3; i++) {
-      // not in sql try and create it
-      if (_dbi->insertMaidenhead(locator, ret_id)) {
-        setMaidenheadIdInMemcached(locator, ret_id);
-        _stats.sql_maidenhead.inserted++;
-        _stompstats.sql_maidenhead.inserted++;
-        return true;
-      } // if
+    // not in sql try and create it
+    if (_dbi->insertMaidenhead(locator, ret_id)) {
+      setMaidenheadIdInMemcached(locator, ret_id);
+      _stats.sql_maidenhead.inserted++;
+      _stompstats.sql_maidenhead.inserted++;
+      return true;
+    } // if
 
-      if (_dbi->getMaidenheadId(locator, ret_id)) {
-        setMaidenheadIdInMemcached(locator, ret_id);
-        return true;
-      } // if
-      sleep(3);
-    } // for
+    // another thread may have beaten us to it
+    if (_dbi->getMaidenheadId(locator, ret_id)) {
+      setMaidenheadIdInMemcached(locator, ret_id);
+      return true;
+    } // if
 
     _stats.sql_maidenhead.failed++;
     _stompstats.sql_maidenhead.failed++;
 
     return false;
+  } // Store::getMaidenheadIdFromSql
+
+  //
+  // memcached and sql both hand back ids as text, these convert
+  // them once for the PacketRecord so nothing downstream has to
+  //
+  bool Store::getCallsignId(const std::string &source, sqlid_t &ret_id) {
+    std::string id;
+    if (!getCallsignId(source, id)) return false;
+    ret_id = PacketRecord::to_id(id);
+    return true;
+  } // Store::getCallsignId
+
+  bool Store::getNameId(const std::string &name, sqlid_t &ret_id) {
+    std::string id;
+    if (!getNameId(name, id)) return false;
+    ret_id = PacketRecord::to_id(id);
+    return true;
+  } // Store::getNameId
+
+  bool Store::getDestId(const std::string &dest, sqlid_t &ret_id) {
+    std::string id;
+    if (!getDestId(dest, id)) return false;
+    ret_id = PacketRecord::to_id(id);
+    return true;
+  } // Store::getDestId
+
+  bool Store::getDigiId(const std::string &name, sqlid_t &ret_id) {
+    std::string id;
+    if (!getDigiId(name, id)) return false;
+    ret_id = PacketRecord::to_id(id);
+    return true;
+  } // Store::getDigiId
+
+  bool Store::getMaidenheadId(const std::string &locator, sqlid_t &ret_id) {
+    std::string id;
+    if (!getMaidenheadId(locator, id)) return false;
+    ret_id = PacketRecord::to_id(id);
+    return true;
   } // Store::getMaidenheadId
 
-  bool Store::setPacketId(const std::string &callsignId, const std::string &packetId) {
+  bool Store::setPacketId(const sqlid_t callsignId, const std::string &packetId) {
     openframe::Stopwatch sw;
-    bool isOK = false;
 
     sw.Start();
 
-    // try again just in case another thread beat us
-    for(int i=0; i < 3; i++) {
-      isOK = _dbi->insertPacket(packetId, callsignId);
-      if (isOK) {
-        _stats.sql_packet.inserted++;
-        _stompstats.sql_packet.inserted++;
-        break;
-      } // if
-
-      sleep(3);
-    } // for
-
-    if (!isOK) {
+    // one attempt only, a failure defers the result and the worker
+    // retries it later
+    bool isOK = _dbi->insertPacket(packetId, callsignId);
+    if (isOK) {
+      _stats.sql_packet.inserted++;
+      _stompstats.sql_packet.inserted++;
+    } // if
+    else {
       _stats.sql_packet.failed++;
       _stompstats.sql_packet.failed++;
-    } // if
+    } // else
 
     _profile->average("sql.insert.packet", sw.Time());
 
@@ -1019,26 +1119,18 @@ namespace aprsinject {
 
   bool Store::getPacketId(const std::string &callsignId, std::string &ret_id) {
     openframe::Stopwatch sw;
-    bool isOK = false;
 
     sw.Start();
 
-    // try again just in case another thread beat us
-    for(int i=0; i < 3; i++) {
-      isOK = _dbi->insertPacket(callsignId, ret_id);
-      if (isOK) {
-        _stats.sql_packet.inserted++;
-        _stompstats.sql_packet.inserted++;
-        break;
-      } // if
-
-      sleep(3);
-    } // for
-
-    if (!isOK) {
+    bool isOK = _dbi->insertPacket(callsignId, ret_id);
+    if (isOK) {
+      _stats.sql_packet.inserted++;
+      _stompstats.sql_packet.inserted++;
+    } // if
+    else {
       _stats.sql_packet.failed++;
       _stompstats.sql_packet.failed++;
-    } // if
+    } // else
 
     _profile->average("sql.insert.packet", sw.Time());
 
@@ -1093,14 +1185,8 @@ namespace aprsinject {
 
     if (!isMemcachedOk()) return false;
 
-    openframe::Vars v;
-    v.add("id", icon.id);
-    v.add("pa", icon.path);
-    v.add("ic", icon.image);
-    v.add("dir", icon.direction);
-
     try {
-      _memcached->put("icon", key, v.compile());
+      _memcached->put("icon", key, _codec.encode(icon) );
     } // try
     catch(MemcachedController_Exception &e) {
       TLOG(LogError, << e.message()
@@ -1121,6 +1207,10 @@ namespace aprsinject {
     std::string buf;
     std::string key;
 
+    // ids are shared by every worker, memcached only gets asked
+    // about the ones this process hasn't seen yet
+    if (findId(IdCache::nsCallsign, IdCache::key_for(IdCache::nsCallsign, source), ret_id)) return true;
+
     if (!isMemcachedOk()) return false;
 
     _stats.cache_callsign.tries++;
@@ -1149,6 +1239,7 @@ namespace aprsinject {
     _stompstats.cache_callsign.hits++;
 
     ret_id = buf;
+    storeId(IdCache::nsCallsign, IdCache::key_for(IdCache::nsCallsign, source), ret_id);
 
     return true;
   } // getCallsignIdFromMemcached
@@ -1160,6 +1251,8 @@ namespace aprsinject {
     assert( source.length() );
     assert( id.length() );
 
+    storeId(IdCache::nsCallsign, IdCache::key_for(IdCache::nsCallsign, source), id);
+
     if (!isMemcachedOk()) return false;
 
     try {
@@ -1183,8 +1276,9 @@ namespace aprsinject {
     openframe::Stopwatch sw;
     std::string buf;
 
-    md5wrapper md5;
-    std::string key = md5.getHashFromString( openframe::StringTool::toUpper(name) );
+    std::string key = KeyHash(KeyHash::foldLower).update(name).hex();
+
+    if (findId(IdCache::nsName, IdCache::key_for(IdCache::nsName, name), ret_id)) return true;
 
     if (!isMemcachedOk()) return false;
 
@@ -1214,6 +1308,7 @@ namespace aprsinject {
     _stompstats.cache_name.hits++;
 
     ret_id = buf;
+    storeId(IdCache::nsName, IdCache::key_for(IdCache::nsName, name), ret_id);
 
     return true;
   } // getNameIdFromMemcached
@@ -1222,10 +1317,11 @@ namespace aprsinject {
     assert( name.length() );
     assert( id.length() );
 
-    md5wrapper md5;
-    std::string key = md5.getHashFromString( openframe::StringTool::toUpper(name) );
+    std::string key = KeyHash(KeyHash::foldLower).update(name).hex();
     bool isOK = true;
 
+    storeId(IdCache::nsName, IdCache::key_for(IdCache::nsName, name), id);
+
     if (!isMemcachedOk()) return false;
 
     try {
@@ -1248,6 +1344,8 @@ namespace aprsinject {
     MemcachedController::memcachedReturnEnum mcr;
     openframe::Stopwatch sw;
 
+    if (findId(IdCache::nsDest, IdCache::key_for(IdCache::nsDest, dest), ret_id)) return true;
+
     if (!isMemcachedOk()) return false;
 
     ++_stats.cache_dest.tries;
@@ -1278,6 +1376,7 @@ namespace aprsinject {
     _stompstats.cache_dest.hits++;
 
     ret_id = buf;
+    storeId(IdCache::nsDest, IdCache::key_for(IdCache::nsDest, dest), ret_id);
 
     return true;
   } // getDestIdFromMemcached
@@ -1288,6 +1387,8 @@ namespace aprsinject {
 
     bool isOK = true;
 
+    storeId(IdCache::nsDest, IdCache::key_for(IdCache::nsDest, dest), id);
+
     if (!isMemcachedOk()) return false;
 
     std::string key = openframe::StringTool::toUpper(dest);
@@ -1311,6 +1412,8 @@ namespace aprsinject {
     MemcachedController::memcachedReturnEnum mcr;
     openframe::Stopwatch sw;
 
+    if (findId(IdCache::nsDigi, IdCache::key_for(IdCache::nsDigi, name), ret_id)) return true;
+
     if (!isMemcachedOk()) return false;
 
     ++_stats.cache_digi.tries;
@@ -1341,6 +1444,7 @@ namespace aprsinject {
     _stompstats.cache_digi.hits++;
 
     ret_id = buf;
+    storeId(IdCache::nsDigi, IdCache::key_for(IdCache::nsDigi, name), ret_id);
 
     return true;
   } // getDigiIdFromMemcached
@@ -1351,6 +1455,8 @@ namespace aprsinject {
 
     bool isOK = true;
 
+    storeId(IdCache::nsDigi, IdCache::key_for(IdCache::nsDigi, name), id);
+
     if (!isMemcachedOk()) return false;
 
     std::string key = openframe::StringTool::toUpper(name);
@@ -1374,6 +1480,8 @@ namespace aprsinject {
     MemcachedController::memcachedReturnEnum mcr;
     openframe::Stopwatch sw;
 
+    if (findId(IdCache::nsMaidenhead, IdCache::key_for(IdCache::nsMaidenhead, locator), ret_id)) return true;
+
     if (!isMemcachedOk()) return false;
 
     ++_stats.cache_maidenhead.tries;
@@ -1404,6 +1512,7 @@ namespace aprsinject {
     _stompstats.cache_maidenhead.hits++;
 
     ret_id = buf;
+    storeId(IdCache::nsMaidenhead, IdCache::key_for(IdCache::nsMaidenhead, locator), ret_id);
 
     return true;
   } // getMaidenheadIdFromMemcached
@@ -1414,6 +1523,8 @@ namespace aprsinject {
 
     bool isOK = true;
 
+    storeId(IdCache::nsMaidenhead, IdCache::key_for(IdCache::nsMaidenhead, locator), id);
+
     if (!isMemcachedOk()) return false;
 
     std::string key = locator;
@@ -1462,6 +1573,221 @@ namespace aprsinject {
     return true;
   } // getIdFromMemcached
 
+  bool Store::findId(const IdCache::namespaceEnum ns, const IdCache::key_t key, std::string &ret_id) {
+    sqlid_t id;
+
+    ++_stats.cache_ids[ns].tries;
+    ++_stompstats.cache_ids[ns].tries;
+
+    if (!_ids->find(ns, key, id)) {
+      ++_stats.cache_ids[ns].misses;
+      ++_stompstats.cache_ids[ns].misses;
+      return false;
+    } // if
+
+    ++_stats.cache_ids[ns].hits;
+    ++_stompstats.cache_ids[ns].hits;
+
+    ret_id = openframe::stringify<sqlid_t>(id);
+    return true;
+  } // findId
+
+  void Store::storeId(const IdCache::namespaceEnum ns, const IdCache::key_t key, const std::string &id) {
+    _ids->store(ns, key, PacketRecord::to_id(id) );
+
+    ++_stats.cache_ids[ns].stored;
+    ++_stompstats.cache_ids[ns].stored;
+  } // storeId
+
+  //
+  // A miss on the id cache and memcached both means a trip to sql and
+  // maybe an insert.  When several workers see a new station at once
+  // only the first one goes, the rest wait for it and read back what
+  // it left behind.  If it's still at it when the wait runs out we
+  // give up on the packet for now and let the retry pick it up.
+  //
+  bool Store::getIdOnce(const IdCache::namespaceEnum ns, const std::string &name, std::string &ret_id,
+                        getId_f fromMemcached, getId_f fromSql) {
+    IdCache::key_t key = IdCache::key_for(ns, name);
+
+    switch( _flights->join(ns, key) ) {
+      case SingleFlight::flightJoined:
+        ++_stats.flight_ids[ns].coalesced;
+        ++_stompstats.flight_ids[ns].coalesced;
+
+        if (findId(ns, key, ret_id)) return true;
+        // the namespace may not be cached or the leader failed
+        if ((this->*fromMemcached)(name, ret_id)) return true;
+        return (this->*fromSql)(name, ret_id);
+      case SingleFlight::flightBusy:
+        ++_stats.flight_ids[ns].busy;
+        ++_stompstats.flight_ids[ns].busy;
+        return false;
+      case SingleFlight::flightLeader:
+        break;
+    } // switch
+
+    ++_stats.flight_ids[ns].leaders;
+    ++_stompstats.flight_ids[ns].leaders;
+
+    bool ok = (this->*fromSql)(name, ret_id);
+    _flights->land(ns, key);
+
+    return ok;
+  } // getIdOnce
+
+  //
+  // Id Batches
+  //
+  // where each namespace lives in memcached and sql, func is what
+  // the single row lookups and inserts wrap the name in
+  struct id_table_t {
+    const char *area;
+    const char *table;
+    const char *column;
+    const char *select_func;
+    const char *insert_func;
+  }; // id_table_t
+
+  static const id_table_t kIdTables[IdCache::nsMax] = {
+    { "callsign", "callsign", "source", "", "UPPER" },
+    { "objectname", "object_name", "name", "TRIM", "TRIM" },
+    { "dest", "destination", "name", "", "UPPER" },
+    { "digi", "digis", "name", "", "UPPER" },
+    // new locators are checked and added by setMaidenhead()
+    { "maidenhead", "maidenhead", "locator", "", NULL }
+  };
+
+  std::string Store::memcachedIdKey(const IdCache::namespaceEnum ns, const std::string &name) {
+    switch(ns) {
+      case IdCache::nsName:
+        return KeyHash(KeyHash::foldLower).update(name).hex();
+      case IdCache::nsMaidenhead:
+        return name;
+      default:
+        break;
+    } // switch
+
+    return openframe::StringTool::toUpper(name);
+  } // memcachedIdKey
+
+  // Resolves what it can of batch into the id cache so the get*Id()
+  // calls that follow are all hits, one mget per namespace and one
+  // select, plus one insert for anything new.  Whatever's left over
+  // goes the usual way.
+  size_t Store::resolveIds(const IdBatch &batch) {
+    size_t resolved = 0;
+
+    for(int i=0; i < IdCache::nsMax; i++) {
+      IdCache::namespaceEnum ns = static_cast<IdCache::namespaceEnum>(i);
+
+      // keyed the same as the cache so whatever sql hands back, in
+      // whatever case, matches up with what was asked for
+      wanted_t wanted;
+      for(IdBatch::names_t::const_iterator itr = batch.names[i].begin(); itr != batch.names[i].end(); itr++) {
+        IdCache::key_t key = IdCache::key_for(ns, *itr);
+        sqlid_t id;
+        if (_ids->find(ns, key, id)) continue;
+        wanted.insert( std::make_pair(key, *itr) );
+      } // for
+
+      _stats.batch_ids.names += batch.names[i].size();
+      _stompstats.batch_ids.names += batch.names[i].size();
+      _stats.batch_ids.cached += batch.names[i].size() - wanted.size();
+      _stompstats.batch_ids.cached += batch.names[i].size() - wanted.size();
+
+      size_t num_wanted = wanted.size();
+      if (!wanted.empty()) resolveIdsFromMemcached(ns, wanted);
+      if (!wanted.empty()) resolveIdsFromSql(ns, wanted);
+      resolved += num_wanted - wanted.size();
+    } // for
+
+    return resolved;
+  } // resolveIds
+
+  void Store::resolveIdsFromMemcached(const IdCache::namespaceEnum ns, wanted_t &wanted) {
+    if (!isMemcachedOk()) return;
+
+    std::vector<std::string> keys;
+    keys.reserve( wanted.size() );
+    for(wanted_itr itr = wanted.begin(); itr != wanted.end(); itr++)
+      keys.push_back( memcachedIdKey(ns, itr->second) );
+
+    openframe::Stopwatch sw;
+    sw.Start();
+
+    std::map<std::string, std::string> found;
+    try {
+      _memcached->mget(kIdTables[ns].area, keys, found);
+    } // try
+    catch(MemcachedController_Exception &e) {
+      TLOG(LogError, << e.message()
+                     << std::endl);
+      _last_cache_fail_at = time(NULL);
+      return;
+    } // catch
+
+    _profile->average("memcached.batch", sw.Time());
+
+    // keys went out in the same order we walk wanted
+    wanted_itr itr = wanted.begin();
+    for(size_t i=0; itr != wanted.end(); i++) {
+      std::map<std::string, std::string>::const_iterator f = found.find(keys[i]);
+      if (f == found.end() || f->second.empty()) {
+        itr++;
+        continue;
+      } // if
+
+      storeId(ns, itr->first, f->second);
+      ++_stats.batch_ids.memcached;
+      ++_stompstats.batch_ids.memcached;
+      wanted.erase(itr++);
+    } // for
+  } // resolveIdsFromMemcached
+
+  void Store::resolveIdsFromSql(const IdCache::namespaceEnum ns, wanted_t &wanted) {
+    const id_table_t &t = kIdTables[ns];
+    openframe::Stopwatch sw;
+
+    sw.Start();
+
+    // second time around whatever sql didn't have gets added first
+    for(int pass=0; pass < 2 && !wanted.empty(); pass++) {
+      std::vector<std::string> names;
+      names.reserve( wanted.size() );
+      for(wanted_itr itr = wanted.begin(); itr != wanted.end(); itr++)
+        names.push_back(itr->second);
+
+      if (pass && (t.insert_func == NULL || !_dbi->insertNames(t.table, t.column, t.insert_func, names)) ) break;
+
+      DBI::idrows_t rows;
+      if (!_dbi->getIdsByName(t.table, t.column, t.select_func, names, rows) ) break;
+
+      for(DBI::idrows_t::const_iterator itr = rows.begin(); itr != rows.end(); itr++) {
+        IdCache::key_t key = IdCache::key_for(ns, itr->second);
+        wanted_itr w = wanted.find(key);
+        if (w == wanted.end()) continue;
+
+        std::string id = openframe::stringify<sqlid_t>(itr->first);
+        storeId(ns, key, id);
+        setIdInMemcached(t.area, memcachedIdKey(ns, w->second), id);
+
+        if (pass) {
+          ++_stats.batch_ids.inserted;
+          ++_stompstats.batch_ids.inserted;
+        } // if
+        else {
+          ++_stats.batch_ids.sql;
+          ++_stompstats.batch_ids.sql;
+        } // else
+
+        wanted.erase(w);
+      } // for
+    } // for
+
+    _profile->average("sql.batch", sw.Time());
+  } // resolveIdsFromSql
+
   bool Store::setIdInMemcached(const std::string &area, const std::string &key, const std::string &id) {
     assert( area.length() );
     assert( key.length() );
@@ -1485,17 +1811,11 @@ namespace aprsinject {
   } // setIdInMemcached
 
   bool Store::setPath(const std::string &packetId, const std::string &path) {
-
-    // try again just in case another thread beat us
-    for(int i=0; i < 3; i++) {
-      if (_dbi->insertPath(packetId, path)) {
-        _stats.sql_path.inserted++;
-        _stompstats.sql_path.inserted++;
-        return true;
-      } // if
-
-      sleep(3);
-    } // for
+    if (_dbi->insertPath(packetId, path)) {
+      _stats.sql_path.inserted++;
+      _stompstats.sql_path.inserted++;
+      return true;
+    } // if
 
     _stats.sql_path.failed++;
     _stompstats.sql_path.failed++;
@@ -1504,18 +1824,11 @@ namespace aprsinject {
   } // Store::setPath
 
   bool Store::setStatus(const std::string &packetId, const std::string &path) {
-
-    // try again just in case another thread beat us
-    for(int i=0; i < 3; i++) {
-      if (_dbi->insertStatus(packetId, path)) {
-        _stats.sql_status.inserted++;
-        _stompstats.sql_status.inserted++;
-
-        return true;
-      } // if
-
-      sleep(3);
-    } // for
+    if (_dbi->insertStatus(packetId, path)) {
+      _stats.sql_status.inserted++;
+      _stompstats.sql_status.inserted++;
+      return true;
+    } // if
 
     _stats.sql_status.failed++;
     _stompstats.sql_status.failed++;
@@ -1526,10 +1839,14 @@ namespace aprsinject {
   //
   // Memcache Duplicates
   //
-  bool Store::getDuplicateFromMemcached(const std::string &key, std::string &ret) {
+  // one atomic add, whoever stores the key first owns the packet and
+  // everyone after that within expires sees it as a duplicate
+  bool Store::isDuplicateInMemcached(const std::string &key, const std::string &buf, const time_t expires) {
     MemcachedController::memcachedReturnEnum mcr;
     openframe::Stopwatch sw;
-    std::string buf;
+
+    assert( key.length() );
+    assert( buf.length() );
 
     if (!isMemcachedOk()) return false;
 
@@ -1539,53 +1856,30 @@ namespace aprsinject {
     sw.Start();
 
     try {
-      mcr = _memcached->get("duplicates", key, buf);
+      mcr = _memcached->add("duplicates", key, buf, expires);
     } // try
     catch(MemcachedController_Exception &e) {
       TLOG(LogError, << e.message()
                      << std::endl);
       _last_cache_fail_at = time(NULL);
+      return false;
     } // catch
 
     _profile->average("memcached.duplicates", sw.Time());
 
-    if (mcr != MemcachedController::MEMCACHED_CONTROLLER_SUCCESS) {
-      _stats.cache_duplicates.misses++;
-      _stompstats.cache_duplicates.misses++;
-      return false;
+    if (mcr == MemcachedController::MEMCACHED_CONTROLLER_EXISTS) {
+      _stats.cache_duplicates.hits++;
+      _stompstats.cache_duplicates.hits++;
+      return true;
     } // if
 
-    _stats.cache_duplicates.hits++;
-    _stompstats.cache_duplicates.hits++;
-
-    ret = buf;
-
-    return true;
-  } // getDuplicateFromMemcached
-
-  bool Store::setDuplicateInMemcached(const std::string &key, const std::string &buf) {
-    bool isOK = true;
-
-    assert( key.length() );
-    assert( buf.length() );
-
-    if (!isMemcachedOk()) return false;
-
-    try {
-      _memcached->put("duplicates", key, buf, 3600);
-    } // try
-    catch(MemcachedController_Exception &e) {
-      TLOG(LogError, << e.message()
-                     << std::endl);
-      _last_cache_fail_at = time(NULL);
-      return false;
-    } // catch
-
+    _stats.cache_duplicates.misses++;
+    _stompstats.cache_duplicates.misses++;
     _stats.cache_duplicates.stored++;
     _stompstats.cache_duplicates.stored++;
 
-    return isOK;
-  } // setDuplicateInMemcached
+    return false;
+  } // isDuplicateInMemcached
 
   //
   // Memcache Positions
@@ -1679,7 +1973,12 @@ namespace aprsinject {
   } // setLocatorSeenInMemcached
 
   bool Store::getLastpositionsFromMemcached(const std::string &locator, std::string &ret) {
-    MemcachedController::memcachedReturnEnum mcr;
+    uint64_t cas;
+    return getLastpositionsFromMemcached(locator, ret, cas);
+  } // getLastpositionsFromMemcached
+
+  bool Store::getLastpositionsFromMemcached(const std::string &locator, std::string &ret, uint64_t &cas) {
+    MemcachedController::memcachedReturnEnum mcr = MemcachedController::MEMCACHED_CONTROLLER_ERROR;
     openframe::Stopwatch sw;
 
     if (!isMemcachedOk()) return false;
@@ -1690,7 +1989,7 @@ namespace aprsinject {
     sw.Start();
 
     try {
-      mcr = _memcached->get("lastpositions", openframe::StringTool::toUpper(locator), ret);
+      mcr = _memcached->gets("lastpositions", openframe::StringTool::toUpper(locator), ret, cas);
     } // try
     catch(MemcachedController_Exception &e) {
       TLOG(LogError, << e.message()
@@ -1712,11 +2011,11 @@ namespace aprsinject {
     return true;
   } // getLastpotitionsFromMemcached
 
-  bool Store::setLastpositionsInMemcached(aprs::APRS *aprs) {
+  bool Store::setLastpositionsInMemcached(aprs::APRS *aprs, const PacketRecord &record) {
     bool isOK = true;
 
-    std::string source = aprs->getString("aprs.packet.source");
-    std::string locator = aprs->getString("aprs.packet.position.maidenhead");
+    const std::string &source = record.source;
+    const std::string &locator = record.locator;
 
     assert( locator.length() );
 
@@ -1727,71 +2026,99 @@ namespace aprsinject {
     openframe::Stopwatch sw;
     sw.Start();
 
-    std::string buf;
-    bool found_locator = getLastpositionsFromMemcached(key, buf);
-
-    // found locator, loop through to find this station
-    // to replace, otherwise create new
-
-    openframe::Vars va;
-    std::string name_id =  aprs->isString("aprs.packet.object.name.id") ? aprs->getString("aprs.packet.object.name.id") : "0";
-    va.add("id", aprs->getString("aprs.packet.id") );
-    va.add("cid", aprs->getString("aprs.packet.callsign.id") );
-    va.add("nid", name_id );
-    va.add("sr", source );
-    if (aprs->is_object())
-      va.add("nm", aprs->getString("aprs.packet.object.name") );
-    va.add("pa", aprs->getString("aprs.packet.path") );
+    LastpositionEntry lp;
+    lp.packet_id = record.packet_id;
+    lp.callsign_id = record.callsign_id;
+    lp.name_id = record.name_id;
+    lp.source = source;
+    if (record.is_object) lp.name = record.name;
+    lp.path = aprs->getString("aprs.packet.path");
     if (aprs->isString("aprs.packet.dirspd.direction"))
-      va.add("cr", aprs->getString("aprs.packet.dirspd.direction") );
+      lp.course = aprs->getString("aprs.packet.dirspd.direction");
     if (aprs->isString("aprs.packet.dirspd.speed"))
-      va.add("sp", aprs->getString("aprs.packet.dirspd.speed") );
+      lp.speed = aprs->getString("aprs.packet.dirspd.speed");
     if (aprs->isString("aprs.packet.altitude"))
-      va.add("at", aprs->getString("aprs.packet.altitude") );
-    va.add("st", aprs->getString("aprs.packet.symbol.table") );
-    va.add("sc", aprs->getString("aprs.packet.symbol.code") );
+      lp.altitude = aprs->getString("aprs.packet.altitude");
+    lp.symbol_table = record.symbol_table;
+    lp.symbol_code = record.symbol_code;
     if (aprs->isString("aprs.packet.symbol.overlay"))
-      va.add("ovr", aprs->getString("aprs.packet.symbol.overlay") );
-    va.add("phgr", aprs->getString("aprs.packet.phg.range") );
-    va.add("phgd", aprs->getString("aprs.packet.phg.directivity") );
-    va.add("ic", aprs->getString("aprs.packet.icon") );
-    va.add("la", aprs->getString("aprs.packet.position.latitude.decimal") );
-    va.add("ln", aprs->getString("aprs.packet.position.longitude.decimal") );
-    va.add("ct", aprs->getString("aprs.packet.timestamp") );
-    va.add("cm", aprs->getString("aprs.packet.comment") );
-    std::string new_lastposition = va.compile();
-
-    std::stringstream out;
-
-    out << new_lastposition << std::endl;
-    if (found_locator) {
-      openframe::StreamParser sp = buf;
-      std::string line;
-      while( sp.sfind('\n', line) ) {
-        openframe::Vars v(line);
-        // invalid? skip!
-        if ( !v.is("sr,ct") ) continue;
-
-        time_t when = atoi( v["CT"].c_str() );
-        // expire anything a day old or more than 100 positions
-        if (when < time(NULL) - 86400) continue;
+      lp.overlay = aprs->getString("aprs.packet.symbol.overlay");
+    lp.phg_range = aprs->getString("aprs.packet.phg.range");
+    lp.phg_directivity = aprs->getString("aprs.packet.phg.directivity");
+    lp.icon = record.icon;
+    lp.latitude = record.latitude;
+    lp.longitude = record.longitude;
+    lp.timestamp = record.timestamp;
+    lp.comment = aprs->getString("aprs.packet.comment");
+
+    // other nodes rewrite the same locator, swap it in with cas so
+    // nobody's entry gets lost and only fall back to a blind put
+    // when it keeps changing underneath us
+    bool stored = false;
+    std::string out;
+    for(int tries = 0; !stored && tries < kLastpositionsRetries; tries++) {
+      std::string buf;
+      uint64_t cas = 0;
+      bool found_locator = getLastpositionsFromMemcached(key, buf, cas);
+
+      out.clear();
+      _codec.begin_list(out, RecordCodec::typeLastpositions);
+      _codec.append(out, lp);
+
+      // found locator, carry over everyone else, only the source and
+      // time of each entry get looked at
+      if (found_locator) {
+        RecordListReader reader(buf, RecordCodec::typeLastpositions);
+        Slice entry;
+        time_t expire_at = time(NULL) - 86400;
+        while( reader.next(entry) ) {
+          std::string entry_source;
+          time_t when;
+          // invalid? skip!
+          if ( !RecordListReader::peek(entry, reader.format(), RecordCodec::typeLastpositions, entry_source, when) ) continue;
+
+          // expire anything a day old
+          if (when < expire_at) continue;
+
+          if (entry_source == source) continue;
+
+          _codec.append(out, RecordCodec::typeLastpositions, entry, reader.format());
+        } // while
+      } // if
 
-        if ( v["sr"] == source) continue;
+      try {
+        MemcachedController::memcachedReturnEnum mcr;
+        if (found_locator)
+          mcr = _memcached->cas("lastpositions", key, out, _memcached->expire(), cas);
+        else
+          mcr = _memcached->add("lastpositions", key, out, _memcached->expire());
+        stored = (mcr == MemcachedController::MEMCACHED_CONTROLLER_SUCCESS);
+      } // try
+      catch(MemcachedController_Exception &e) {
+        TLOG(LogError, << e.message()
+                       << std::endl);
+        _last_cache_fail_at = time(NULL);
+        return false;
+      } // catch
+
+      if (!stored) {
+        ++_stats.cache_lastpositions.conflicts;
+        ++_stompstats.cache_lastpositions.conflicts;
+      } // if
+    } // for
 
-        out << line << std::endl;
-      } // while
+    if (!stored) {
+      try {
+        _memcached->put("lastpositions", key, out);
+      } // try
+      catch(MemcachedController_Exception &e) {
+        TLOG(LogError, << e.message()
+                       << std::endl);
+        _last_cache_fail_at = time(NULL);
+        return false;
+      } // catch
     } // if
 
-    try {
-      _memcached->put("lastpositions", key, out.str() );
-    } // try
-    catch(MemcachedController_Exception &e) {
-      TLOG(LogError, << e.message()
-                     << std::endl);
-      _last_cache_fail_at = time(NULL);
-      return false;
-    } // catch
-
     _profile->average("memcached.lastpositions", sw.Time());
     CALC_PROFILE(_stompstats.prof_cache_lastpositions, sw.Time());
 
@@ -1834,15 +2161,15 @@ namespace aprsinject {
     return true;
   } // getPositionsFromMemcached
 
-  bool Store::setPositionsInMemcached(aprs::APRS *aprs) {
+  bool Store::setPositionsInMemcached(aprs::APRS *aprs, const PacketRecord &record) {
     bool isOK = true;
 
     // don't store positions for objects, WINLINK sends positions
     // like crazy and objects should replce each other not be tracked
-    if ( aprs->isString("aprs.packet.position.posdup") || aprs->is_object() ) return false;
+    if (record.posdup || record.is_object) return false;
 
-    std::string key = aprs->getString("aprs.packet.callsign.id");
-    assert( key.length() );
+    assert(record.callsign_id != 0);
+    std::string key = openframe::stringify<sqlid_t>(record.callsign_id);
 
     if (!isMemcachedOk()) return false;
 
@@ -1852,37 +2179,38 @@ namespace aprsinject {
     std::string buf;
     bool found_positions = getPositionsFromMemcached(key, buf);
 
-    openframe::Vars va;
-    va.add("L", aprs->getString("aprs.packet.position.latitude.decimal") );
-    va.add("G", aprs->getString("aprs.packet.position.longitude.decimal") );
-    va.add("T", aprs->getString("aprs.packet.timestamp") );
-    std::string new_position = va.compile();
+    TrailEntry te;
+    te.latitude = record.latitude;
+    te.longitude = record.longitude;
+    te.timestamp = record.timestamp;
 
-    // found locator, loop through to find this station
-    // to replace, otherwise create new
-    std::stringstream out;
-    out << new_position << std::endl;
+    std::string out;
+    _codec.begin_list(out, RecordCodec::typeTrail);
+    _codec.append(out, te);
+
+    // newest first, keep what's behind us
     if (found_positions) {
-      openframe::StreamParser sp = buf;
-      std::string line;
+      RecordListReader reader(buf, RecordCodec::typeTrail);
+      Slice entry;
+      time_t expire_at = time(NULL) - 86400;
       int c = 0;
-      while( sp.sfind('\n', line) ) {
-        openframe::Vars v(line);
+      while( reader.next(entry) ) {
+        std::string unused;
+        time_t when;
         // invalid? skip!
-        if ( !v.is("L,G,T") ) continue;
+        if ( !RecordListReader::peek(entry, reader.format(), RecordCodec::typeTrail, unused, when) ) continue;
 
-        time_t when = atoi( v["T"].c_str() );
         // expire anything a day old or more than 100 positions
-        if (when < time(NULL) - 86400 || c > 100) break;
+        if (when < expire_at || c > 100) break;
 
-        out << line << std::endl;
+        _codec.append(out, RecordCodec::typeTrail, entry, reader.format());
         ++c;
       } // while
     } // if
 
     try {
       // expire positions after a day has passed
-      _memcached->put("positions", key, out.str(), 86400);
+      _memcached->put("positions", key, out, 86400);
     } // try
     catch(MemcachedController_Exception &e) {
       TLOG(LogError, << e.message() << std::endl);
@@ -1899,41 +2227,46 @@ namespace aprsinject {
     return isOK;
   } // setPositionsInMemcached
 
-  bool Store::injectPosition(aprs::APRS *aprs) {
+  bool Store::injectPosition(aprs::APRS *aprs, const PacketRecord &record, const int flags) {
     openframe::Stopwatch sw;
 
-    sw.Start();
-    setLastpositionsInMemcached(aprs);
-    _profile->average("memcached.insert.position", sw.Time());
+    if ( !(flags & DBI::positionSkipState) ) {
+      sw.Start();
+      setLastpositionsInMemcached(aprs, record);
+      _profile->average("memcached.insert.position", sw.Time());
+    } // if
     
-    setPositionsInMemcached(aprs);
+    // the trail is only for drawing recent tracks, not worth it
+    // while we're behind
+    if ( !(flags & DBI::positionSkipExtras) )
+      setPositionsInMemcached(aprs, record);
 
     sw.Start();
-    bool ok = _dbi->position(aprs);
+    bool ok = _dbi->position(aprs, record, flags);
     _profile->average("sql.insert.position", sw.Time());
 
     return ok;
   } // Store::injectPosition
 
-  bool Store::injectMessage(aprs::APRS *aprs) {
+  bool Store::injectMessage(aprs::APRS *aprs, const PacketRecord &record) {
     openframe::Stopwatch sw;
 
     sw.Start();
-    bool ok = _dbi->message(aprs);
+    bool ok = _dbi->message(aprs, record);
     _profile->average("sql.insert.message", sw.Time());
 
     return ok;
   } // Store::injectMessage
 
-  bool Store::injectTelemtry(aprs::APRS *aprs) {
-    return _dbi->telemetry(aprs);
+  bool Store::injectTelemtry(aprs::APRS *aprs, const PacketRecord &record) {
+    return _dbi->telemetry(aprs, record);
   } // Store::injectTelemtry
 
-  bool Store::injectRaw(aprs::APRS *aprs) {
+  bool Store::injectRaw(aprs::APRS *aprs, const PacketRecord &record) {
     openframe::Stopwatch sw;
 
     sw.Start();
-    bool ok = _dbi->raw(aprs);
+    bool ok = _dbi->raw(aprs, record);
     _profile->average("sql.insert.raw", sw.Time());
 
     return ok;
@@ -1,5 +1,6 @@
 #include "config.h"
 
+#include <algorithm>
 #include <string>
 
 #include <stdarg.h>
@@ -13,6 +14,13 @@
 #include <aprs/aprs.h>
 
 #include <Worker.h>
+#include <ResultQueue.h>
+#include <ShardRouter.h>
+#include <RetryWheel.h>
+#include <ParserPool.h>
+#include <StompSource.h>
+#include <FileSource.h>
+#include <EventLoop.h>
 #include <Store.h>
 #include <MemcachedController.h>
 #include <DBI.h>
@@ -21,12 +29,28 @@ namespace aprsinject {
   using namespace openframe::loglevel;
 
   const int Worker::kDefaultStompPrefetch	= 1024;
+  const size_t Worker::kDefaultInjectBatch	= 100;
+  // results are packets not frames, a full prefetch window of frames
+  // carries several packets each
+  const size_t Worker::kDefaultBacklogHigh	= Worker::kDefaultStompPrefetch * 4;
+  const size_t Worker::kDefaultBacklogLow	= Worker::kDefaultStompPrefetch;
+  const unsigned int Worker::kDefaultRetryMax	= 5;
+  const time_t Worker::kDefaultRetryBackoff	= 1;
+  const time_t Worker::kDefaultRetryBackoffMax	= 60;
+  const time_t Worker::kDefaultCatchupAge	= 0;
+  const time_t Worker::kDefaultCatchupRecover	= 60;
+  const size_t Worker::kDefaultCatchupBatch	= Worker::kDefaultInjectBatch * 4;
+  // in ms, the broker connection gives us no descriptor to sleep on
+  // so an idle reader backs off between these
+  const int Worker::kMinIdleWait		= 1;
+  const int Worker::kMaxIdleWait		= 10;
   const time_t Worker::kDefaultStatsInterval	= 3600;
   const time_t Worker::kDefaultMemcachedExpire	= 3600;
   const char *Worker::kStompDestErrors		= "/topic/feeds.aprs.is.errors";
   const char *Worker::kStompDestRejects		= "/topic/feeds.aprs.is.rejects";
   const char *Worker::kStompDestDuplicates	= "/topic/feeds.aprs.is.duplicates";
   const char *Worker::kStompDestNotifyMessages	= "/topic/notify.aprs.messages";
+  const char *Worker::kStompDestDeadLetter	= "/topic/feeds.aprs.is.deadletter";
 
   Worker::Worker(const openframe::LogObject::thread_id_t thread_id,
                  const std::string &stomp_hosts,
@@ -53,10 +77,45 @@ namespace aprsinject {
 
     _store = NULL;
     _stomp = NULL;
+    _input = NULL;
+    _loop = NULL;
+    _idle_wait = kMinIdleWait;
+    _queue = NULL;
+    _router = NULL;
+    _stage = stageAll;
+    _acks = NULL;
+    _ack_mode = AckTracker::ackModeFrame;
+    _ack_batch = AckTracker::kDefaultBatch;
+    _backlog_high = kDefaultBacklogHigh;
+    _backlog_low = kDefaultBacklogLow;
+    _backlogged = false;
+    _catchup_age = kDefaultCatchupAge;
+    _catchup_recover = kDefaultCatchupRecover;
+    _catchup = false;
+    _lag = 0.0;
+    _load = NULL;
+    _retries = NULL;
+    _retry_max = kDefaultRetryMax;
+    _parsers = NULL;
+    _num_parsers = 0;
+    _batch_ids = true;
+    _pool = NULL;
+    _own_pool = false;
+    _duplicates = NULL;
+    _own_duplicates = false;
+    _remote_duplicates = false;
+    _preparse_duplicates = true;
+    _record_format = RecordCodec::formatText;
+    _stations = NULL;
+    _ids = NULL;
+    _flights = NULL;
+    _own_stations = false;
+    _remote_stations = false;
     _profile = NULL;
     _connected = false;
     _console = false;
     _locators_intval = new openframe::Intval(5);
+    _stations_intval = new openframe::Intval(1);
 
     init_stats(_stats, true);
     init_stompstats(_stompstats, true);
@@ -67,14 +126,36 @@ namespace aprsinject {
   Worker::~Worker() {
     onDestroyStats();
 
+    // ack whatever made it to the database before we let go of
+    // the frames still in flight, the broker will redeliver those
+    if (_acks) {
+      if (_connected) try_acks(true);
+      delete _acks;
+    } // if
+
+    if (_input) delete _input;
+    if (_queue) _queue->set_notify(NULL);
+    if (_loop) delete _loop;
+
+    if (_retries) delete _retries;
+    if (_parsers) delete _parsers;
+
     while( !_results.empty() ) {
       Result *result = _results.front();
       result->release();
       _results.pop_front();
     } // while
 
+    if (_own_pool) delete _pool;
+    if (_own_duplicates) delete _duplicates;
+    if (_own_stations) delete _stations;
+
     delete _locators_intval;
-    if (_store) delete _store;
+    delete _stations_intval;
+    if (_store) {
+      try_stations(true);
+      delete _store;
+    } // if
     if (_stomp) delete _stomp;
     if (_profile) delete _profile;
   } // Worker:~Worker
@@ -90,17 +171,58 @@ namespace aprsinject {
                                 _stomp_passcode,
                                 headers);
 
-      _store = new Store(thread_id(),
-                         _db_host,
-                         _db_user,
-                         _db_pass,
-                         _db_database,
-                         _memcached_host,
-                         kDefaultMemcachedExpire,
-                         kDefaultStatsInterval);
-      _store->replace_stats( stats(), "");
-      _store->set_elogger( elogger(), elog_name() );
-      _store->init();
+      _loop = new EventLoop();
+      // ingest wakes us when it hands over work
+      if (_queue) _queue->set_notify(_loop);
+
+      // the inject stage never subscribes so has nothing to ack
+      // or parse
+      if (!is_stage(stageInject)) {
+        // outgoing messages still go through _stomp when replaying
+        if (_input_file.empty())
+          _input = new StompSource(_stomp, _stomp_dest,
+                                   _ack_mode == AckTracker::ackModeCumulative ? StompSource::kAckClient
+                                                                              : StompSource::kAckClientIndividual);
+        else
+          _input = new FileSource(_input_file, _input_speed);
+        _acks = new AckTracker(_ack_mode, _ack_batch);
+        // pipeline stages share a pool handed to us by App
+        if (!_pool) {
+          _pool = new ResultPool();
+          _own_pool = true;
+        } // if
+        if (_num_parsers) {
+          _parsers = new ParserPool(_num_parsers);
+          _parsers->start();
+        } // if
+      } // if
+
+      // the ingest stage never touches the database
+      if (!is_stage(stageIngest)) {
+        if (!_duplicates) {
+          _duplicates = new DuplicateTable();
+          _own_duplicates = true;
+        } // if
+        if (!_stations) {
+          _stations = new StationTable();
+          _own_stations = true;
+        } // if
+        _retries = new RetryWheel();
+        _store = new Store(thread_id(),
+                           _db_host,
+                           _db_user,
+                           _db_pass,
+                           _db_database,
+                           _memcached_host,
+                           kDefaultMemcachedExpire,
+                           kDefaultStatsInterval);
+        _store->replace_stats( stats(), "");
+        _store->set_elogger( elogger(), elog_name() );
+        _store->set_record_format(_record_format);
+        if (_ids) _store->set_ids(_ids);
+        if (_flights) _store->set_flights(_flights);
+        _store->init();
+      } // if
     } // try
     catch(std::bad_alloc &xa) {
       assert(false);
@@ -111,6 +233,7 @@ namespace aprsinject {
     _profile->add("time.loop.preprocess", 300);
     _profile->add("time.loop.process", 300);
     _profile->add("time.loop.inject", 300);
+    _profile->add("time.loop.resolve", 300);
     _profile->add("time.aprs.parse", 300);
 
   } // Worker::init
@@ -118,6 +241,7 @@ namespace aprsinject {
   void Worker::init_stats(obj_stats_t &stats, const bool startup) {
     stats.connects = 0;
     stats.disconnects = 0;
+    stats.acks = 0;
     stats.packets = 0;
     stats.age = 0;
     stats.frames_in = 0;
@@ -129,6 +253,24 @@ namespace aprsinject {
 
   void Worker::init_stompstats(obj_stompstats_t &stats, const bool startup) {
     memset(&stats.aprs_stats, 0, sizeof(aprs_stats_t) );
+    stats.backlog_peak = 0;
+    stats.backlog_pauses = 0;
+    stats.retry_scheduled = 0;
+    stats.retry_expired = 0;
+    stats.retry_deadletter = 0;
+    stats.catchup_switches = 0;
+    stats.catchup_reduced = 0;
+    stats.result_allocs = 0;
+    stats.result_reuses = 0;
+    stats.dup_local = 0;
+    stats.dup_remote = 0;
+    stats.dup_remote_checks = 0;
+    stats.dup_preparse = 0;
+    stats.station_local = 0;
+    stats.station_remote = 0;
+    stats.station_flushed = 0;
+    stats.wakeups = 0;
+    stats.wake_time = 0.0;
 
     stats.last_report_at = time(NULL);
     if (startup) stats.created_at = time(NULL);
@@ -143,6 +285,26 @@ namespace aprsinject {
     describe_stat("num.work.in", "worker"+thread_id_str()+"/num work in", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeSum);
     describe_stat("num.work.out", "worker"+thread_id_str()+"/work out", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeSum);
     describe_stat("num.result.queue", "worker"+thread_id_str()+"/num result queue", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeSum);
+    describe_stat("num.pipeline.queue", "worker"+thread_id_str()+"/num pipeline queue", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeMean);
+    describe_stat("num.acks.out", "worker"+thread_id_str()+"/num acks out", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeSum);
+    describe_stat("num.acks.pending", "worker"+thread_id_str()+"/num acks pending", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeMean);
+    describe_stat("num.backlog", "worker"+thread_id_str()+"/num backlog", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeMean);
+    describe_stat("num.backlog.peak", "worker"+thread_id_str()+"/num backlog peak", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeMean);
+    describe_stat("num.backlog.high", "worker"+thread_id_str()+"/num backlog high watermark", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeMean);
+    describe_stat("num.backlog.low", "worker"+thread_id_str()+"/num backlog low watermark", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeMean);
+    describe_stat("num.backlog.pauses", "worker"+thread_id_str()+"/num backlog pauses", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeSum);
+    describe_stat("num.retry.pending", "worker"+thread_id_str()+"/num retry pending", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeMean);
+    describe_stat("num.retry.scheduled", "worker"+thread_id_str()+"/num retry scheduled", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeSum);
+    describe_stat("num.retry.expired", "worker"+thread_id_str()+"/num retry expired", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeSum);
+    describe_stat("num.retry.deadletter", "worker"+thread_id_str()+"/num retry deadletter", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeSum);
+    describe_stat("num.catchup", "worker"+thread_id_str()+"/num catchup", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeMean);
+    describe_stat("num.catchup.switches", "worker"+thread_id_str()+"/num catchup switches", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeSum);
+    describe_stat("num.catchup.reduced", "worker"+thread_id_str()+"/num catchup reduced writes", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeSum);
+    describe_stat("time.catchup.lag", "worker"+thread_id_str()+"/catchup lag", openstats::graphTypeGauge, openstats::dataTypeFloat, openstats::useTypeMean);
+    describe_stat("num.result.allocs", "worker"+thread_id_str()+"/num result allocs", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeSum);
+    describe_stat("num.result.reuses", "worker"+thread_id_str()+"/num result reuses", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeSum);
+    describe_stat("num.result.allocs.per.packet", "worker"+thread_id_str()+"/num result allocs per packet", openstats::graphTypeGauge, openstats::dataTypeFloat, openstats::useTypeMean);
+    describe_stat("num.pipeline.stalls", "worker"+thread_id_str()+"/num pipeline stalls", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeSum);
     describe_stat("num.aprs.rejects", "worker"+thread_id_str()+"/aprs rejects", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeSum);
     describe_stat("num.aprs.duplicates", "worker"+thread_id_str()+"/aprs duplicates", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeSum);
     describe_stat("num.aprs.position.error", "worker"+thread_id_str()+"/aprs position errors", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeSum);
@@ -151,10 +313,30 @@ namespace aprsinject {
     describe_stat("num.sql.inserted", "worker"+thread_id_str()+"/sql inserted", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeSum);
     describe_stat("num.sql.failed", "worker"+thread_id_str()+"/sql failed", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeSum);
     describe_stat("time.run", "worker"+thread_id_str()+"/run loop time", openstats::graphTypeGauge, openstats::dataTypeFloat, openstats::useTypeMean);
+    describe_stat("num.lane.message", "worker"+thread_id_str()+"/num lane message", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeMean);
+    describe_stat("num.lane.position", "worker"+thread_id_str()+"/num lane position", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeMean);
+    describe_stat("num.lane.bulk", "worker"+thread_id_str()+"/num lane bulk", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeMean);
+    describe_stat("time.lane.message.wait", "worker"+thread_id_str()+"/lane message wait time", openstats::graphTypeGauge, openstats::dataTypeFloat, openstats::useTypeMean);
+    describe_stat("time.lane.message.wait.max", "worker"+thread_id_str()+"/lane message wait time max", openstats::graphTypeGauge, openstats::dataTypeFloat, openstats::useTypeMean);
+    describe_stat("time.lane.position.wait", "worker"+thread_id_str()+"/lane position wait time", openstats::graphTypeGauge, openstats::dataTypeFloat, openstats::useTypeMean);
+    describe_stat("time.lane.position.wait.max", "worker"+thread_id_str()+"/lane position wait time max", openstats::graphTypeGauge, openstats::dataTypeFloat, openstats::useTypeMean);
+    describe_stat("time.lane.bulk.wait", "worker"+thread_id_str()+"/lane bulk wait time", openstats::graphTypeGauge, openstats::dataTypeFloat, openstats::useTypeMean);
+    describe_stat("time.lane.bulk.wait.max", "worker"+thread_id_str()+"/lane bulk wait time max", openstats::graphTypeGauge, openstats::dataTypeFloat, openstats::useTypeMean);
+    describe_stat("num.dup.local", "worker"+thread_id_str()+"/num duplicates local", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeSum);
+    describe_stat("num.dup.remote", "worker"+thread_id_str()+"/num duplicates remote", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeSum);
+    describe_stat("num.dup.remote.checks", "worker"+thread_id_str()+"/num duplicates remote checks", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeSum);
+    describe_stat("num.dup.preparse", "worker"+thread_id_str()+"/num duplicates preparse", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeSum);
+    describe_stat("num.station.local", "worker"+thread_id_str()+"/num station local", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeSum);
+    describe_stat("num.station.remote", "worker"+thread_id_str()+"/num station remote", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeSum);
+    describe_stat("num.station.flushed", "worker"+thread_id_str()+"/num station flushed", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeSum);
+    describe_stat("num.loop.wakeups", "worker"+thread_id_str()+"/num loop wakeups", openstats::graphTypeGauge, openstats::dataTypeInt, openstats::useTypeSum);
+    // eventfd wakeups only, see Worker::wait()
+    describe_stat("time.loop.wake", "worker"+thread_id_str()+"/loop wake latency", openstats::graphTypeGauge, openstats::dataTypeFloat, openstats::useTypeMean);
     describe_stat("time.run.handle", "worker"+thread_id_str()+"/run handle time", openstats::graphTypeGauge, openstats::dataTypeFloat, openstats::useTypeMean);
     describe_stat("time.run.preprocess", "worker"+thread_id_str()+"/run preprocess time", openstats::graphTypeGauge, openstats::dataTypeFloat, openstats::useTypeMean);
     describe_stat("time.run.process", "worker"+thread_id_str()+"/run process time", openstats::graphTypeGauge, openstats::dataTypeFloat, openstats::useTypeMean);
     describe_stat("time.run.inject", "worker"+thread_id_str()+"/run inject time", openstats::graphTypeGauge, openstats::dataTypeFloat, openstats::useTypeMean);
+    describe_stat("time.run.resolve", "worker"+thread_id_str()+"/run resolve time", openstats::graphTypeGauge, openstats::dataTypeFloat, openstats::useTypeMean);
     describe_stat("time.aprs.parse", "worker"+thread_id_str()+"/aprs parse time", openstats::graphTypeGauge, openstats::dataTypeFloat, openstats::useTypeMean);
     describe_stat("time.sql.insert", "worker"+thread_id_str()+"/sql insert time", openstats::graphTypeGauge, openstats::dataTypeFloat, openstats::useTypeMean);
     describe_stat("time.write.event", "worker"+thread_id_str()+"/write event time", openstats::graphTypeGauge, openstats::dataTypeFloat, openstats::useTypeMean);
@@ -210,7 +392,8 @@ namespace aprsinject {
     double pps = double(_stats.packets) / diff;
     double fps_in = double(_stats.frames_in) / diff;
     double fps_out = double(_stats.frames_out) / diff;
-    time_t age = _stats.age / _stats.packets;
+    // pipeline stages only see one side of the work, don't divide by zero
+    time_t age = _stats.packets ? _stats.age / _stats.packets : 0;
 
     TLOG(LogNotice, << "Stats packets " << _stats.packets
                     << ", pps " << pps << "/s"
@@ -220,8 +403,9 @@ namespace aprsinject {
                     << ", fps out " << fps_out << "/s"
                     << ", age " << age << "s"
                     << ", next in " << _stats.report_interval
+                    << ", acks " << _stats.acks
                     << ", connect attempts " << _stats.connects
-                    << "; " << _stomp->connected_to()
+                    << "; " << (_input ? _input->describe() : _stomp->connected_to())
                     << std::endl);
 
     init_stats(_stats);
@@ -230,12 +414,68 @@ namespace aprsinject {
 
   void Worker::try_stompstats() {
     if (_stompstats.last_report_at > time(NULL) - _stompstats.report_interval) return;
-    datapoint_float("aprs_stats.rate.age", (_stompstats.aprs_stats.age / _stompstats.aprs_stats.packet));
+    if (_stompstats.aprs_stats.packet)
+      datapoint_float("aprs_stats.rate.age", (_stompstats.aprs_stats.age / _stompstats.aprs_stats.packet));
+    if (_queue) datapoint("num.pipeline.queue", _queue->size());
+    if (_router) datapoint("num.pipeline.queue", _router->size());
+    if (_acks) datapoint("num.acks.pending", _acks->pending());
+    if (_retries) {
+      datapoint("num.retry.pending", _retries->size());
+      datapoint("num.retry.scheduled", _stompstats.retry_scheduled);
+      datapoint("num.retry.expired", _stompstats.retry_expired);
+      datapoint("num.retry.deadletter", _stompstats.retry_deadletter);
+    } // if
+    if (!is_stage(stageIngest) && _catchup_age) {
+      datapoint("num.catchup", _catchup ? 1 : 0);
+      datapoint("num.catchup.switches", _stompstats.catchup_switches);
+      datapoint("num.catchup.reduced", _stompstats.catchup_reduced);
+      datapoint_float("time.catchup.lag", _lag);
+    } // if
+    if (_duplicates) {
+      datapoint("num.dup.local", _stompstats.dup_local);
+      datapoint("num.dup.remote", _stompstats.dup_remote);
+      datapoint("num.dup.remote.checks", _stompstats.dup_remote_checks);
+      datapoint("num.dup.preparse", _stompstats.dup_preparse);
+    } // if
+    if (_stations) {
+      datapoint("num.station.local", _stompstats.station_local);
+      datapoint("num.station.remote", _stompstats.station_remote);
+      datapoint("num.station.flushed", _stompstats.station_flushed);
+    } // if
+    if (!is_stage(stageInject)) {
+      unsigned int created = _stompstats.result_allocs + _stompstats.result_reuses;
+      datapoint("num.result.allocs", _stompstats.result_allocs);
+      datapoint("num.result.reuses", _stompstats.result_reuses);
+      if (created)
+        datapoint_float("num.result.allocs.per.packet", double(_stompstats.result_allocs) / created);
+
+      datapoint("num.backlog", _results.size());
+      datapoint("num.backlog.peak", _stompstats.backlog_peak);
+      datapoint("num.backlog.high", _backlog_high);
+      datapoint("num.backlog.low", _backlog_low);
+      datapoint("num.backlog.pauses", _stompstats.backlog_pauses);
+    } // if
+
+    for(int i=0; i < ResultLanes::numLanes; i++) {
+      ResultLanes::laneEnum lane = static_cast<ResultLanes::laneEnum>(i);
+      const ResultLanes::lane_stats_t &stats = _results.stats(lane);
+      std::string name = ResultLanes::lane_name(lane);
+      datapoint("num.lane."+name, _results.size(lane));
+      if (!stats.count) continue;
+      datapoint_float("time.lane."+name+".wait", stats.wait / stats.count);
+      datapoint_float("time.lane."+name+".wait.max", stats.wait_max);
+    } // for
+    _results.reset_stats();
+
+    datapoint("num.loop.wakeups", _stompstats.wakeups);
+    if (_stompstats.wakeups)
+      datapoint_float("time.loop.wake", _stompstats.wake_time / _stompstats.wakeups);
 
     datapoint_float("time.run.handle", _profile->average("time.loop.handle"));
     datapoint_float("time.run.preprocess", _profile->average("time.loop.preprocess"));
     datapoint_float("time.run.process", _profile->average("time.loop.process"));
     datapoint_float("time.run.inject", _profile->average("time.loop.inject"));
+    datapoint_float("time.run.resolve", _profile->average("time.loop.resolve"));
     datapoint_float("time.aprs.parse", _profile->average("time.aprs.parse"));
 
     datapoint("aprs_stats.rate.packet", _stompstats.aprs_stats.packet);
@@ -277,113 +517,225 @@ namespace aprsinject {
 
   bool Worker::run() {
     try_stats();
-    _store->try_stats();
+    if (_store) _store->try_stats();
     try_locators();
+    try_stations();
+    if (_retries) try_retries();
+    if (_load) publish_load();
+
+    if (is_stage(stageInject)) return run_inject();
+
+    try_acks();
+
+    size_t num_handled = 0;
+    if (is_stage(stageIngest)) {
+      // inject stage is behind, don't read anymore frames until
+      // we've handed off what we already have
+      if (!dispatch_results()) return false;
+    } // if
+    else {
+      num_handled = handle_results();
+      // lag only moves when packets come through, an idle worker
+      // shouldn't keep reporting how far behind it last was
+      if (!num_handled) _lag -= _lag * 0.05;
+    } // else
 
-    handle_results();
+    /******************
+     ** Flow Control **
+     ******************/
+    // stop pulling frames while we're backed up, the broker holds
+    // onto anything past the prefetch window until we catch up
+    if (is_backlogged()) return num_handled > 0;
 
     /**********************
      ** Check Connection **
      **********************/
     if (!_connected) {
       ++_stats.connects;
-      bool ok = _stomp->subscribe(_stomp_dest, "1");
+      bool ok = _input->open();
       if (!ok) {
-        TLOG(LogInfo, << "not connected, retry in 2 seconds; " << _stomp->last_error() << std::endl);
+        TLOG(LogInfo, << "not connected, retry in 2 seconds; " << _input->last_error() << std::endl);
         sleep(2);
         return false;
       } // if
       _connected = true;
-      TLOG(LogNotice, << "Connected to " << _stomp->connected_to() << std::endl);
+      TLOG(LogNotice, << "Connected to " << _input->describe() << std::endl);
     } // if
 
-    stomp::StompFrame *frame;
+    if (_input->is_eof()) return false;
+
+    InputBatch batch;
     bool ok = false;
 
     try {
-      ok = _stomp->next_frame(frame);
+      ok = _input->next(batch);
     } // try
-    catch(stomp::Stomp_Exception &ex) {
+    catch(InputSource_Exception &ex) {
       TLOG(LogWarn, << "ERROR: " << ex.message() << std::endl);
       _connected = false;
       ++_stats.disconnects;
+      // message ids from the old connection can't be acked anymore
+      _acks->reset();
       return false;
     } // catch
 
-    if (!ok) return false;
+    if (!ok) {
+      if (_input->is_eof())
+        TLOG(LogNotice, << "Finished " << _input->describe() << std::endl);
+      return false;
+    } // if
 
     /*******************
      ** Process Frame **
      *******************/
     ++_stats.frames_in;
-    bool is_usable = frame->is_command(stomp::StompFrame::commandMessage)
-                     && frame->is_header("message-id");
-    if (!is_usable) {
-      frame->release();
-      return true;
-    } // if
-    ++_stats.frames_in;
 
-    openframe::StreamParser sp = frame->body();
-    std::string packet;
-    while( sp.sfind('\n', packet) ) {
+    _idle_wait = kMinIdleWait;
+
+    // replayed input has nothing to ack
+    FrameAck *frame_ack = batch.id.empty() ? NULL : _acks->track(batch.id);
+
+    // walk the frame body in place, only a kept Result gets its own copy
+    LineSlicer ls(batch.body.data(), batch.body.length());
+    Slice line;
+    ParserPool::jobs_t jobs;
+    while( ls.next(line) ) {
       ++_stats.packets;
-      openframe::StreamParser spp = packet;
 
       // find timestamp
-      std::string aprs_created_str;
-      if (!spp.sfind(' ', aprs_created_str)) continue; // skip this line
-      time_t aprs_created = atoi( aprs_created_str.c_str() );
+      Slice aprs_created_str, body;
+      if (!line.split(' ', aprs_created_str, body)) continue; // skip this line
+      time_t aprs_created = aprs_created_str.to_long();
 
       _stats.age += abs(time(NULL) - aprs_created);
       _stompstats.aprs_stats.age += abs(time(NULL) - aprs_created);
 
-      Result *result = create_result(spp.str(), aprs_created);
+      // the same packet shows up through every igate that heard it,
+      // drop the copies before paying for a parse
+      uint64_t dup_key = 0;
+      bool has_dup_key = _preparse_duplicates && _duplicates && duplicate_key(body, dup_key);
+      if (has_dup_key && _duplicates->check(dup_key, aprs_created)) {
+        ++_stompstats.dup_local;
+        ++_stompstats.dup_preparse;
+        Slice header, info;
+        body.split(':', header, info);
+        reject_duplicate(body, info);
+        continue;
+      } // if
 
-      // add to process list
-      if (result) _results.push_back(result);
+      ParserPool::job_t job;
+      job.result = create_result(body);
+      job.result->_dup_key = dup_key;
+      job.result->_dup_checked = has_dup_key;
+      job.timestamp = aprs_created;
+      jobs.push_back(job);
     } // while
 
-    std::string message_id = frame->get_header("message-id");
-    _stomp->ack(message_id, "1");
+    // big frames get spread across the parser pool, either way the
+    // jobs come back in the order they arrived in
+    if (_parsers && jobs.size() >= _parsers->min_batch())
+      _parsers->parse(jobs);
+    else {
+      for(ParserPool::jobs_itr itr = jobs.begin(); itr != jobs.end(); itr++)
+        itr->result->parse(itr->timestamp);
+    } // else
+
+    for(ParserPool::jobs_itr itr = jobs.begin(); itr != jobs.end(); itr++) {
+      Result *result = finish_result(itr->result);
+      if (!result) continue;
+
+      if (frame_ack) result->set_frame_ack(frame_ack);
+
+      // add to process list
+      _results.push_back(result);
+    } // for
+
+    if (is_stage(stageIngest)) dispatch_results();
 
-    frame->release();
+    if (_acks->is_mode(AckTracker::ackModeFrame) && !batch.id.empty()) {
+      _input->ack(batch.id);
+      ++_stats.acks;
+    } // if
+
+    _input->release(batch);
     return true;
   } // Worker::run
 
-  Result *Worker::create_result(const std::string &body, const time_t timestamp) {
-    Result *result;
-    try {
-      result = new Result(body, time(NULL) );
-    } // try
-    catch(std::bad_alloc &xa) {
-      assert(false);
-    } // catch
+  Result *Worker::create_result(const Slice &body) {
+    bool allocated;
+    Result *result = _pool->acquire(body, time(NULL), allocated);
+
+    if (allocated) ++_stompstats.result_allocs;
+    else ++_stompstats.result_reuses;
+
+    return result;
+  } // Worker::create_result
+
+  void Worker::recycle(Result *result) {
+    assert(result != NULL);		// bug
+
+    if (result->_pool) result->_pool->recycle(result);
+    else result->release();
+  } // Worker::recycle
+
+  Result *Worker::finish_result(Result *result) {
+    assert(result != NULL);		// bug
+
+    if ( result->is_status(Result::statusRejected) ) {
+      _stompstats.aprs_stats.reject_invparse++;
+      post_error(kStompDestErrors, result->_packet, result);
+      print_result(result);
 
+      recycle(result);
+      return NULL;
+    } // if
+
+    _profile->average("time.aprs.parse", result->parseTime());
+
+    return result;
+  } // Worker::finish_result
+
+  // may be called from a parser pool thread, only touch the result
+  bool Result::parse(const time_t timestamp) {
     openframe::Stopwatch sw;
     try {
       sw.Start();
-      result->_aprs = new aprs::APRS(body, timestamp);
-      _profile->average("time.aprs.parse", sw.Time());
+      _aprs = _pool ? _pool->create_aprs(_packet, timestamp) : new aprs::APRS(_packet, timestamp);
+      _parseTime = sw.Time();
     } // try
     catch(aprs::APRS_Exception &e) {
-      result->_aprs = NULL;
-      result->_error = e.message();
-      result->_status = Result::statusRejected;
-      _stompstats.aprs_stats.reject_invparse++;
-      post_error(kStompDestErrors, body, result);
-      print_result(result);
-
-      result->release();
-      return NULL;
+      _aprs = NULL;
+      _error = e.message();
+      _status = statusRejected;
+      return false;
     } // catch
 
+    // pull out what the inject path needs once, while we're still
+    // on whichever thread did the parsing
+    _record.extract(_aprs);
+
     // at this point we've parsed ok, if anything else resets this
     // then the packet wasn't ok
-    result->_status = Result::statusOk;
+    _status = statusOk;
 
-    return result;
-  } // Worker::create_result
+    return true;
+  } // Result::parse
+
+  void Result::clear() {
+    if (_aprs) {
+      if (_pool) _pool->destroy_aprs(_aprs);
+      else delete _aprs;
+      _aprs = NULL;
+    } // if
+
+    // we're finished, let the frame we came from be acked
+    if (_frame_ack) {
+      _frame_ack->release();
+      _frame_ack = NULL;
+    } // if
+
+    _error.erase();
+  } // Result::clear
 
   size_t Worker::handle_results() {
     /*****************************
@@ -391,66 +743,341 @@ namespace aprsinject {
      *****************************/
     openframe::Stopwatch sw;
     size_t num_handled = 0;
-    int retries = 0;
-    while(!_results.empty() && num_handled < 100 && retries < 3) {
+    // bigger passes while catching up, less time spent on the rest
+    // of the loop between them
+    size_t batch = _catchup ? kDefaultCatchupBatch : kDefaultInjectBatch;
+
+    // run the checks over the whole pass first, rejects are finished
+    // there and then and only what's left has its ids looked up
+    // together before anything is injected
+    std::vector<Result *> pass;
+    while(!_results.empty() && num_handled + pass.size() < batch) {
       Result *result = _results.front();
+      _results.pop_front();
+
+      sw.Start();
+      bool ok = screen(result);
+      if (ok) {
+        pass.push_back(result);
+        continue;
+      } // if
+      _profile->average("time.loop.handle", sw.Time());
+
+      print_result(result);
+      ++num_handled;
+      recycle(result);
+    } // while
+
+    if (_batch_ids && pass.size() > 1) resolve_ids(pass);
+    if (_catchup) mark_superseded(pass);
+
+    for(size_t i=0; i < pass.size(); i++) {
+      Result *result = pass[i];
 
       sw.Start();
       bool ok = handle(result);
       _profile->average("time.loop.handle", sw.Time());
 
       print_result(result);
+      ++num_handled;
 
-      if (ok) {
-        _results.pop_front();
-        result->release();
-        ++num_handled;
+      // failures go to the retry wheel so the rest of the stream
+      // keeps moving while this one backs off
+      if (ok) recycle(result);
+      else defer(result);
+    } // for
+
+    return num_handled;
+  } // Worker::handle_results
+
+  // Everything preprocess() is about to ask Store for, one name at a
+  // time, for results that made it past the checks.  Retries already
+  // had their turn here, whatever they still lack goes the slow way.
+  void Worker::resolve_ids(const std::vector<Result *> &results) {
+    openframe::Stopwatch sw;
+    IdBatch batch;
+
+    sw.Start();
+
+    for(size_t n=0; n < results.size(); n++) {
+      if (!results[n]->is_status(Result::statusOk)) continue;
+      const PacketRecord &record = results[n]->record();
+
+      batch.add(IdCache::nsCallsign, record.source);
+      batch.add(IdCache::nsDest, record.dest);
+      if (record.has_name()) batch.add(IdCache::nsName, record.name);
+      if (record.type == aprs::APRS::APRS_PACKET_POSITION) batch.add(IdCache::nsMaidenhead, record.locator);
+      if (record.type == aprs::APRS::APRS_PACKET_MESSAGE) batch.add(IdCache::nsCallsign, record.target);
+      for(size_t i=0; i < record.num_digis; i++)
+        batch.add(IdCache::nsDigi, record.digis[i]);
+    } // for
+
+    _store->resolveIds(batch);
+    _profile->average("time.loop.resolve", sw.Time());
+  } // Worker::resolve_ids
+
+  void Worker::defer(Result *result) {
+    assert(result != NULL);		// bug
+
+    // we only keep retrying forever if we've been told not to drop
+    bool is_dead = _drop_defer && result->_retries >= _retry_max;
+    if (is_dead) {
+      TLOG(LogWarn, << "Giving up on result after " << result->_retries
+                    << " retries; " << result->_error << std::endl);
+      post_error(kStompDestDeadLetter, result->_packet, result);
+      ++_stompstats.retry_deadletter;
+      recycle(result);
+      return;
+    } // if
+
+    time_t backoff = kDefaultRetryBackoff << std::min(result->_retries, 16U);
+    if (backoff > kDefaultRetryBackoffMax) backoff = kDefaultRetryBackoffMax;
+
+    TLOG(LogWarn, << "Errors detected while handling result, retry #"
+                  << result->_retries+1 << " in " << backoff << "s; "
+                  << result->_error << std::endl);
+
+    result->_retries++;
+    _retries->schedule(result, backoff);
+    ++_stompstats.retry_scheduled;
+  } // Worker::defer
+
+  void Worker::try_retries() {
+    // put them at the front, they've already waited long enough
+    RetryWheel::results_t ready;
+    size_t num_expired = _retries->expire(ready);
+    if (!num_expired) return;
+
+    while( !ready.empty() ) {
+      _results.push_front(ready.back());
+      ready.pop_back();
+    } // while
+
+    _stompstats.retry_expired += num_expired;
+  } // Worker::try_retries
+
+  // Being scaled down, we've stopped reading so see everything we
+  // still hold through before letting go.  With stomp.ack.mode=frame
+  // those frames were acked already and nothing would bring them back.
+  void Worker::drain() {
+    // ingest and inject stages aren't scaled
+    if (!is_stage(stageAll) || !_acks) return;
+
+    if (_retries) {
+      RetryWheel::results_t ready;
+      size_t num_expired = _retries->expire_all(ready);
+      while( !ready.empty() ) {
+        _results.push_front(ready.back());
+        ready.pop_back();
+      } // while
+      _stompstats.retry_expired += num_expired;
+    } // if
+
+    // whatever gets deferred again here is out of chances
+    while( !_results.empty() )
+      handle_results();
+
+    if (_retries && !_retries->empty())
+      TLOG(LogWarn, << "Stopping with " << _retries->size()
+                    << " results still failing, giving them up" << std::endl);
+
+    if (_connected) try_acks(true);
+  } // Worker::drain
+
+  bool Worker::dispatch_results() {
+    assert(_router != NULL || _queue != NULL);		// bug
+
+    while( !_results.empty() ) {
+      Result *result = _results.front();
+      bool ok = _router ? _router->push(result) : _queue->push(result);
+      // a full shard holds up the rest so results keep their order
+      if (!ok) {
+        datapoint("num.pipeline.stalls", 1);
+        return false;
       } // if
-      else {
-        TLOG(LogWarn, << "Errors detected while handling result, try #" << retries+1 << std::endl);
-        bool shouldDrop = _drop_defer && result->is_status(Result::statusDeferred) && retries < 3;
-        if (shouldDrop) {
-          _results.pop_front();
-          result->release();
+      _results.pop_front();
+    } // while
 
-          ++num_handled;
+    return true;
+  } // Worker::dispatch_results
 
-          continue;
-        } // if
+  bool Worker::is_backlogged() {
+    results_st backlog = _results.size();
+    if (is_stage(stageIngest)) backlog += _router ? _router->size() : _queue->size();
+    if (_retries) backlog += _retries->size();
 
-        retries++;
-        sleep(3);
-      } // else
+    if (backlog > _stompstats.backlog_peak) _stompstats.backlog_peak = backlog;
+
+    if (!_backlogged && backlog >= _backlog_high) {
+      TLOG(LogInfo, << "Backlog " << backlog << " reached high watermark "
+                    << _backlog_high << ", pausing reads" << std::endl);
+      _backlogged = true;
+      ++_stompstats.backlog_pauses;
+    } // if
+    else if (_backlogged && backlog <= _backlog_low) {
+      TLOG(LogInfo, << "Backlog " << backlog << " reached low watermark "
+                    << _backlog_low << ", resuming reads" << std::endl);
+      _backlogged = false;
+    } // else if
+
+    return _backlogged;
+  } // Worker::is_backlogged
+
+  void Worker::try_catchup(const Result *result) {
+    // smooth it out, one old straggler shouldn't flip us over
+    time_t age = time(NULL) - result->record().timestamp;
+    if (age < 0) age = 0;
+    _lag += (age - _lag) * 0.05;
+
+    if (!_catchup_age) return;
+
+    if (!_catchup && _lag >= _catchup_age) {
+      TLOG(LogNotice, << "Lag " << _lag << "s reached " << _catchup_age
+                      << "s, entering catch up mode" << std::endl);
+      _catchup = true;
+      ++_stompstats.catchup_switches;
+    } // if
+    else if (_catchup && _lag <= _catchup_recover) {
+      TLOG(LogNotice, << "Lag " << _lag << "s back under " << _catchup_recover
+                      << "s, leaving catch up mode" << std::endl);
+      _catchup = false;
+      _newest.clear();
+      ++_stompstats.catchup_switches;
+    } // else if
+  } // Worker::try_catchup
+
+  void Worker::publish_load() {
+    _load->lag = _lag;
+    _load->backlog = _results.size() + (_retries ? _retries->size() : 0);
+    _load->db_time = _profile->average("time.loop.inject");
+  } // Worker::publish_load
+
+  // A catch up pass is mostly in time order, so the last position per
+  // station in it is the one worth writing state for.
+  void Worker::mark_superseded(const std::vector<Result *> &results) {
+    std::map<std::string, size_t> last;
+
+    for(size_t n=0; n < results.size(); n++) {
+      Result *result = results[n];
+      result->_superseded = false;
+
+      const PacketRecord &record = result->record();
+      if (record.type != aprs::APRS::APRS_PACKET_POSITION) continue;
+
+      const std::string &station = record.has_name() ? record.name : record.source;
+      std::map<std::string, size_t>::iterator itr = last.find(station);
+      if (itr == last.end()) {
+        last[station] = n;
+        continue;
+      } // if
+
+      Result *other = results[itr->second];
+      if (other->record().timestamp > record.timestamp) {
+        result->_superseded = true;
+        continue;
+      } // if
+
+      other->_superseded = true;
+      itr->second = n;
+    } // for
+  } // Worker::mark_superseded
+
+  int Worker::position_flags(const Result *result) {
+    if (!_catchup) return DBI::positionAll;
+
+    ++_stompstats.catchup_reduced;
+    int flags = DBI::positionSkipExtras;
+
+    if (result->_superseded) return flags | DBI::positionSkipState;
+
+    // only the newest packet we've seen for a station gets to
+    // update its last known state, older ones just go into history
+    const PacketRecord &record = result->record();
+    const std::string &station = record.has_name() ? record.name : record.source;
+    newest_itr itr = _newest.find(station);
+    if (itr != _newest.end() && itr->second > record.timestamp)
+      flags |= DBI::positionSkipState;
+    else
+      _newest[station] = record.timestamp;
+
+    return flags;
+  } // Worker::position_flags
+
+  bool Worker::run_inject() {
+    assert(_queue != NULL);		// bug
+
+    size_t num_pulled = 0;
+    Result *result;
+    // pull in more than a batch so messages sitting further back in
+    // the shard get a chance to jump ahead of bulk traffic
+    while(_results.size() < _backlog_high && _queue->pop(result) ) {
+      _results.push_back(result);
+      ++num_pulled;
     } // while
 
-    return num_handled;
-  } // Worker::handle_results
+    size_t num_handled = handle_results();
 
-  bool Worker::handle(Result *result) {
+    return num_pulled || num_handled;
+  } // Worker::run_inject
+
+  void Worker::wait() {
+    _loop->arm();
+    // ingest handed us something after we last looked
+    if (_queue && !_queue->empty()) {
+      _loop->disarm();
+      return;
+    } // if
+
+    // the inject stage only ever waits on its queue and the tick,
+    // readers have to go back and ask the broker
+    int timeout = _input ? _idle_wait : -1;
+    int events = _loop->wait(timeout);
+
+    if (events & EventLoop::eventWake) {
+      ++_stompstats.wakeups;
+      _stompstats.wake_time += _loop->wake_latency();
+    } // if
+
+    // broker frames don't come in through the loop, readers just
+    // sleep out the timeout so time.loop.wake is only ever reported
+    // by inject workers woken by ingest
+    if (_input) _idle_wait = std::min(_idle_wait * 2, kMaxIdleWait);
+  } // Worker::wait
+
+  // False if the result was rejected, it's been posted and there's
+  // nothing left to do with it.
+  bool Worker::screen(Result *result) {
     assert(result != NULL);
     aprs::APRS *aprs = result->aprs();
     assert(aprs != NULL);
 
-    bool ok = result->is_status(Result::statusDeferred);
     // only check for dups if we're not deferred
+    if (result->is_status(Result::statusDeferred)) return true;
+
+    try_catchup(result);
+
+    bool ok = !checkForDuplicates(result) && !checkForPositionErrors(result);
+    // either this was a duplicate or a position error, in which case
+    // we will do nothing for this packet
     if (!ok) {
-      ok = !checkForDuplicates(result) && !checkForPositionErrors(result);
-      // either this was a duplicate or a position error, in which case
-      // we will do nothing for this packet
-      if (!ok) {
-        if (!result->_error.length() && result->_aprs->isString("aprs.packet.error.message"))
-          result->_error = result->_aprs->getString("aprs.packet.error.message");
-        post_error(kStompDestRejects, aprs->packet(), result);
-        return true;
-      } // if
+      if (!result->_error.length() && result->_aprs->isString("aprs.packet.error.message"))
+        result->_error = result->_aprs->getString("aprs.packet.error.message");
+      post_error(kStompDestRejects, aprs->packet(), result);
     } // if
 
+    return ok;
+  } // Worker::screen
+
+  bool Worker::handle(Result *result) {
+    assert(result != NULL);
+    assert(result->aprs() != NULL);
+
     // at this point we're past rejecting let's get all of our
     // needed ids in order to proceed
     openframe::Stopwatch sw;
 
     sw.Start();
-    ok = preprocess(result);
+    bool ok = preprocess(result);
     _profile->average("time.loop.preprocess", sw.Time());
 
     if (!ok) {
@@ -479,39 +1106,35 @@ namespace aprsinject {
     assert(result != NULL);
     aprs::APRS *aprs = result->aprs();
     assert(aprs != NULL);
+    PacketRecord &record = result->_record;
 
     // take care of callsign id
-    std::string callsignId;
-    bool ok = _store->getCallsignId(result->_aprs->source(), callsignId);
+    bool ok = _store->getCallsignId(record.source, record.callsign_id);
     if (!ok) {
       result->_status = Result::statusDeferred;
       result->_error = "could not get callsign id";
       return false;
     } // if
-    aprs->replaceString("aprs.packet.callsign.id", callsignId);
 
     // take care of callsign id
-    ok = aprs->isString("aprs.packet.symbol.table") && aprs->isString("aprs.packet.symbol.code");
-    if (ok) {
+    if (record.symbol_table.length()) {
       Icon icon;
-      int course = (aprs->isString("aprs.packet.dirspd.direction") ? atoi(aprs->getString("aprs.packet.dirspd.direction").c_str()) : 0);
-      ok = _store->getIconBySymbol(aprs->getString("aprs.packet.symbol.table"), aprs->getString("aprs.packet.symbol.code"), course, icon);
+      ok = _store->getIconBySymbol(record.symbol_table, record.symbol_code, record.has_course ? record.course : 0, icon);
       if (ok) {
-        aprs->replaceString("aprs.packet.icon.id", icon.id);
-        aprs->replaceString("aprs.packet.icon", icon.icon);
+        record.icon_id = PacketRecord::to_id(icon.id);
+        record.icon = icon.icon;
       } // if
       else {
         result->_status = Result::statusDeferred;
         result->_error = "could not get icon id for "
-                         + aprs->getString("aprs.packet.symbol.table")
-                         + aprs->getString("aprs.packet.symbol.code");
+                         + record.symbol_table
+                         + record.symbol_code;
         return false;
       } // else
     } // if
 
     // take care of packet id
-    std::string packetId = aprs->getString("aprs.packet.uuid.id");
-    ok = _store->setPacketId(callsignId, packetId);
+    ok = _store->setPacketId(record.callsign_id, record.packet_id);
     if (!ok) {
       result->_status = Result::statusDeferred;
       result->_error = "could not get packet id";
@@ -519,8 +1142,6 @@ namespace aprsinject {
       return false;
     } // if
 
-    aprs->replaceString("aprs.packet.id", packetId);
-
     // take care of path id
     // ok = _store->setPath(packetId, result->_aprs->path());
     // if (!ok) {
@@ -530,29 +1151,24 @@ namespace aprsinject {
     // } // if
 
     // take care of dest id
-    std::string destId;
-    std::string dest = aprs->getString("aprs.packet.path0");
-    ok = _store->getDestId(dest, destId);
+    ok = _store->getDestId(record.dest, record.dest_id);
     if (!ok) {
       result->_status = Result::statusDeferred;
       result->_error = "could not get destination id";
       return false;
     } // if
-    aprs->replaceString("aprs.packet.destination.id", destId);
 
-    if (result->_aprs->isString("aprs.packet.object.name")) {
-      std::string nameId;
-      ok = _store->getNameId( result->_aprs->getString("aprs.packet.object.name") , nameId);
+    if (record.has_name()) {
+      ok = _store->getNameId(record.name, record.name_id);
       if (!ok) {
         result->_status = Result::statusDeferred;
         result->_error = "could not get name id";
         return false;
       } // if
-      aprs->replaceString("aprs.packet.object.name.id", nameId);
     } // if
 
     // if we're a position or status report we'll have some additional text as a comment
-    if (result->_aprs->packetType() == aprs::APRS::APRS_PACKET_POSITION) {
+    if (record.type == aprs::APRS::APRS_PACKET_POSITION) {
       // ok = _store->setStatus(packetId, result->_aprs->status());
       // if (!ok) {
       //   result->_status = Result::statusDeferred;
@@ -560,53 +1176,36 @@ namespace aprsinject {
       //   return false;
       // } // if
 
-      if (aprs->isString("aprs.packet.position.maidenhead")) {
+      if (record.locator.length()) {
         // take care of digi id
-        std::string maidenheadId;
-        std::string locator = aprs->getString("aprs.packet.position.maidenhead");
-        ok = _store->getMaidenheadId(locator, maidenheadId);
+        ok = _store->getMaidenheadId(record.locator, record.maidenhead_id);
         if (!ok) {
           result->_status = Result::statusDeferred;
           result->_error = "could not get maidenhead id";
           return false;
         } // if
-
-        aprs->replaceString("aprs.packet.position.maidenhead.sql.id", maidenheadId);
       } // if
     } // if
 
     // if we're a message we need to find the to callsign
-    if (result->_aprs->packetType() == aprs::APRS::APRS_PACKET_MESSAGE) {
-      std::string targetId;
-      std::string target = result->_aprs->getString("aprs.packet.message.target");
-      ok = _store->getCallsignId(target, targetId);
+    if (record.type == aprs::APRS::APRS_PACKET_MESSAGE) {
+      ok = _store->getCallsignId(record.target, record.target_id);
       if (!ok) {
         result->_status = Result::statusDeferred;
         result->_error = "could not get message target callsign id";
         return false;
       } // if
-      aprs->replaceString("aprs.packet.message.target.id", targetId);
     } // if
 
     // work on digipath
-    for(int i=1; i < 9; i++) {
-      std::string digi = "aprs.packet.path" + openframe::stringify<int>(i);
-      std::string name = aprs->getString(digi);
-
-      if ( !name.length() ) {
-        aprs->replaceString(digi + ".id", "0");
-        continue;
-      } // if
-
+    for(size_t i=0; i < record.num_digis; i++) {
       // take care of digi id
-      std::string digiId;
-      ok = _store->getDigiId(name, digiId);
+      ok = _store->getDigiId(record.digis[i], record.digi_ids[i]);
       if (!ok) {
         result->_status = Result::statusDeferred;
-        result->_error = "could not get digi id for path " + openframe::stringify<int>(i);
+        result->_error = "could not get digi id for path " + openframe::stringify<size_t>(i+1);
         return false;
       } // if
-      aprs->replaceString(digi + ".id", digiId);
     } // for
 
     return result;
@@ -616,27 +1215,28 @@ namespace aprsinject {
     assert(result != NULL);
     aprs::APRS *aprs = result->aprs();
     assert(aprs != NULL);
+    const PacketRecord &record = result->record();
 
-    bool ok = _store->injectRaw(aprs);
+    bool ok = _store->injectRaw(aprs, record);
     if (!ok) {
       result->_status = Result::statusDeferred;
       result->_error = "could not inject raw";
       return false;
     } // if
 
-    switch(aprs->packetType()) {
+    switch(record.type) {
       case aprs::APRS::APRS_PACKET_POSITION:
-        ok = _store->injectPosition(aprs);
+        ok = _store->injectPosition(aprs, record, position_flags(result));
         if (!ok) {
           result->_status = Result::statusDeferred;
           result->_error = "could not inject position";
           return false;
         } // if
 
-        _locators.insert( aprs->getString("aprs.packet.position.maidenhead") );
+        _locators.insert(record.locator);
         break;
       case aprs::APRS::APRS_PACKET_MESSAGE:
-        ok = _store->injectMessage(aprs);
+        ok = _store->injectMessage(aprs, record);
         if (!ok) {
           result->_status = Result::statusDeferred;
           result->_error = "could not inject message";
@@ -644,7 +1244,7 @@ namespace aprsinject {
         } // if
         break;
       case aprs::APRS::APRS_PACKET_TELEMETRY:
-        ok = _store->injectTelemtry(aprs);
+        ok = _store->injectTelemtry(aprs, record);
         if (!ok) {
           result->_status = Result::statusDeferred;
           result->_error = "could not inject telemtry";
@@ -695,59 +1295,77 @@ namespace aprsinject {
 
   bool Worker::checkForDuplicates(Result *result) {
     aprs::APRS *aprs = result->_aprs;
-    openframe::Vars *v;
-    md5wrapper md5;
+    uint64_t key = result->_dup_key;
+    if (!result->_dup_checked
+        && !duplicate_key( Slice(result->_packet.data(), result->_packet.length()), key) )
+      key = KeyHash(KeyHash::foldLower).update( aprs->source() ).update(':').update( aprs->body() ).digest();
+
+    // most dups are caught here without leaving the process, another
+    // node only gets asked about what we haven't seen ourselves, if
+    // the raw line was already checked it missed locally
+    bool is_dup = !result->_dup_checked && _duplicates->check(key, aprs->timestamp());
+    if (is_dup) ++_stompstats.dup_local;
+    else if (_remote_duplicates) {
+      is_dup = checkForRemoteDuplicates(result, KeyHash::to_hex(key));
+      ++_stompstats.dup_remote_checks;
+      if (is_dup) ++_stompstats.dup_remote;
+    } // else if
+
+    if (is_dup) {
+      result->_status = Result::statusDuplicate;
+      _stompstats.aprs_stats.reject_duplicate++;
+      post_error(kStompDestDuplicates, result->_aprs->body(), result);
+    } // if
 
-    std::string body = openframe::StringTool::toLower(aprs->source() + ":" + aprs->body());
-    std::string key = md5.getHashFromString(body);
+    return is_dup;
+  } // Worker::checkForDuplicates
 
-    bool is_dup = false;
-    std::string buf;
-    bool found = _store->getDuplicateFromMemcached(key, buf);
+  // Source and information field straight off the raw line, the path
+  // in between is left out since it differs with every igate.
+  bool Worker::duplicate_key(const Slice &packet, uint64_t &key) {
+    Slice source, rest, header, info;
+    if (!packet.split('>', source, rest) || source.empty()) return false;
+    if (!rest.split(':', header, info)) return false;
 
-    if (found) {
+    key = KeyHash(KeyHash::foldLower).update( source.data(), source.length() )
+                                     .update(':')
+                                     .update( info.data(), info.length() ).digest();
+    return true;
+  } // Worker::duplicate_key
+
+  // Dropped before parsing, tell the same topics handle() would have.
+  void Worker::reject_duplicate(const Slice &packet, const Slice &info) {
+    Result *result = create_result(packet);
+    result->_status = Result::statusDuplicate;
+    _stompstats.aprs_stats.reject_duplicate++;
+    post_error(kStompDestDuplicates, info.str(), result);
+    post_error(kStompDestRejects, result->_packet, result);
+    recycle(result);
+  } // Worker::reject_duplicate
+
+  bool Worker::checkForRemoteDuplicates(Result *result, const std::string &key) {
+    const PacketRecord &record = result->record();
+    DuplicateEntry entry;
+    entry.source = record.source;
+    entry.timestamp = record.timestamp;
+    entry.has_position = result->_aprs->packetType() == aprs::APRS::APRS_PACKET_POSITION;
+    entry.latitude = record.latitude;
+    entry.longitude = record.longitude;
+
+    // the key expires with the window, so if the add loses another
+    // node stored the same packet within it
+    bool is_dup = _store->isDuplicateInMemcached(key, _store->codec().encode(entry), _duplicates->window() );
+    if (is_dup) {
       TLOG(LogDebug, << "memcached{dup} found key " << key << std::endl);
-      TLOG(LogDebug, << "memcached{dup} body: " << body << std::endl);
-      TLOG(LogDebug, << "memcached{dup} data: " << buf);
-
-      v = new openframe::Vars(buf);
-      bool exists = v->exists("ct");
-      if (exists) {
-        time_t diff = time(NULL) - atoi( (*v)["ct"].c_str() );
-        if (diff < 30) {
-          result->_status = Result::statusDuplicate;
-          _stompstats.aprs_stats.reject_duplicate++;
-          post_error(kStompDestDuplicates, result->_aprs->body(), result);
-          is_dup = true;
-        } // if
-      } // if
-      else assert(false);	// bug
-      delete v;
+      TLOG(LogDebug, << "memcached{dup} body: " << result->_aprs->body() << std::endl);
     } // if
-    else {
-      // not found must add it
-      v = new openframe::Vars();
-
-      v->add("sr", result->_aprs->source());
-      v->add("ct", result->_aprs->getString("aprs.packet.timestamp"));
-      if (result->_aprs->packetType() == aprs::APRS::APRS_PACKET_POSITION) {
-        v->add("la", result->_aprs->getString("aprs.packet.position.latitude.decimal"));
-        v->add("ln", result->_aprs->getString("aprs.packet.position.longitude.decimal"));
-      } // if
-
-      v->compile(buf, "");
-      delete v;
-
-      _store->setDuplicateInMemcached(key, buf);
-    } // else
 
     return is_dup;
-  } // Worker::checkForDuplicates
+  } // Worker::checkForRemoteDuplicates
 
   bool Worker::checkForPositionErrors(Result *result) {
     aprs::APRS *aprs = result->_aprs;
-    openframe::Vars *v;
-    md5wrapper md5;
+    const PacketRecord &record = result->record();
 
     if (aprs->packetType() != aprs::APRS::APRS_PACKET_POSITION
         || aprs->is_object())
@@ -755,88 +1373,118 @@ namespace aprsinject {
       // can present multiple positions by same source quickly
       return false;
 
-    std::string key = openframe::StringTool::toLower(aprs->source());
-    std::string buf;
+    StationTable::key_t station_key = KeyHash::hash(record.source, KeyHash::foldLower);
+    uint64_t comment = KeyHash().update( aprs->getString("aprs.packet.comment") ).digest();
 
-    bool found = _store->getPositionFromMemcached(key, buf);
-    bool is_posit_error = false;
+    // another node may have heard from this station last, only worth
+    // asking if they share through memcached
+    StationTable::station_t last;
+    bool found = _stations->find(station_key, last);
+    if (found) ++_stompstats.station_local;
+    else if (_remote_stations) {
+      found = getRemoteStation(record.source, last);
+      ++_stompstats.station_remote;
+    } // else if
 
-    std::string comment = md5.getHashFromString(aprs->getString("aprs.packet.comment"));
+    bool is_posit_error = false;
     if (found) {
       // do position err checks
-      v = new openframe::Vars(buf);
-
-      // is it a position we can use?
-      if (v->exists("la,ln,ct,cm")) {
-        double tlat = atof((*v)["la"].c_str());
-        double tlng = atof((*v)["ln"].c_str());
-        time_t ct = atol((*v)["ct"].c_str());
-
-        double distance = aprs::APRS::calcDistance(tlat, tlng, aprs->lat(), aprs->lng(), 'M');
-
-        // packets can arrive out of order which can cause a negative timestamp
-        // since we only want the time difference take absolute value
-        time_t diff = abs(aprs->timestamp() - ct);
-
-        // pos dups tells the injector not to add to positions table
-        // this should catch repeaters and other fixed stations (like WX) from
-        // clogging up the positions table; we want to catch fast reports
-        // and reports that are less than 0.1 miles.
-        if (diff < 1 || distance < 0.1) aprs->addString("aprs.packet.position.posdup", "1");
-
-        double speed = aprs::APRS::calcSpeed(distance, diff, 8, 1);
-
-        if (diff < 5 && comment == (*v)["cm"]) {
-          // probably don't want to do this, catches digis that advertise
-          // two packets with different comment content
-          TLOG(LogDebug, << "memcached{pos}, found key " << key << std::endl);
-          TLOG(LogDebug, << "memcached{pos}, data: " << buf);
-          TLOG(LogDebug, << "memcached{pos}, pos: "
-                        << aprs->lat() << "," << aprs->lng()
-                        << std::endl);
-          TLOG(LogDebug, << "memcached{pos}, lame: " << diff << "seconds"
-                        << std::endl);
-          _stompstats.aprs_stats.reject_tosoon++;
-          aprs->addString("aprs.packet.error.message", "position: tx < 5 seconds (" + openframe::stringify<time_t>(diff) + ")");
-          is_posit_error = true;
-        } // if
-        else if (speed > 500 && comment == (*v)["cm"]) {
-          TLOG(LogDebug, << "memcached{pos}, found key " << key << std::endl);
-          TLOG(LogDebug, << "memcached{pos}, data: " << buf << std::endl);
-          TLOG(LogDebug, << "memcached{pos}, pos: " << aprs->lat() << "," << aprs->lng()
-                        << std::endl);
-          TLOG(LogDebug, << "memcached{pos}, lame: speed " << speed << std::endl);
-          _stompstats.aprs_stats.reject_tofast++;
-          aprs->addString("aprs.packet.error.message", "position: gps glitch speed > 500");
-          is_posit_error = true;
-        } // else if
-
+      double tlat = last.latitude;
+      double tlng = last.longitude;
+      time_t ct = last.timestamp;
+
+      double distance = aprs::APRS::calcDistance(tlat, tlng, aprs->lat(), aprs->lng(), 'M');
+
+      // packets can arrive out of order which can cause a negative timestamp
+      // since we only want the time difference take absolute value
+      time_t diff = abs(aprs->timestamp() - ct);
+
+      // pos dups tells the injector not to add to positions table
+      // this should catch repeaters and other fixed stations (like WX) from
+      // clogging up the positions table; we want to catch fast reports
+      // and reports that are less than 0.1 miles.
+      // the record was extracted before we got here so has to be
+      // told too, that's what the injection reads
+      if (diff < 1 || distance < 0.1) {
+        aprs->addString("aprs.packet.position.posdup", "1");
+        result->_record.posdup = true;
       } // if
 
-      delete v;
+      double speed = aprs::APRS::calcSpeed(distance, diff, 8, 1);
+
+      if (diff < 5 && comment == last.comment) {
+        // probably don't want to do this, catches digis that advertise
+        // two packets with different comment content
+        TLOG(LogDebug, << "station{pos}, found " << record.source << std::endl);
+        TLOG(LogDebug, << "station{pos}, pos: "
+                      << aprs->lat() << "," << aprs->lng()
+                      << std::endl);
+        TLOG(LogDebug, << "station{pos}, lame: " << diff << "seconds"
+                      << std::endl);
+        _stompstats.aprs_stats.reject_tosoon++;
+        aprs->addString("aprs.packet.error.message", "position: tx < 5 seconds (" + openframe::stringify<time_t>(diff) + ")");
+        is_posit_error = true;
+      } // if
+      else if (speed > 500 && comment == last.comment) {
+        TLOG(LogDebug, << "station{pos}, found " << record.source << std::endl);
+        TLOG(LogDebug, << "station{pos}, pos: " << aprs->lat() << "," << aprs->lng()
+                      << std::endl);
+        TLOG(LogDebug, << "station{pos}, lame: speed " << speed << std::endl);
+        _stompstats.aprs_stats.reject_tofast++;
+        aprs->addString("aprs.packet.error.message", "position: gps glitch speed > 500");
+        is_posit_error = true;
+      } // else if
 
       if (is_posit_error) result->_status = Result::statusPositError;
     } // if
 
     if ( result->is_status(Result::statusOk) ) {
-      v = new openframe::Vars();
+      StationTable::station_t station;
+      station.latitude = record.latitude;
+      station.longitude = record.longitude;
+      station.timestamp = record.timestamp;
+      station.comment = comment;
+      _stations->store(station_key, station);
+
+      // written out with the next flush, a station that sends again
+      // before then only costs us one set
+      if (_remote_stations) _pending_stations[record.source] = station;
+    } // if
 
-      v->add("sr", aprs->source());
-      v->add("la", aprs->getString("aprs.packet.position.latitude.decimal"));
-      v->add("ln", aprs->getString("aprs.packet.position.longitude.decimal"));
-      v->add("ct", aprs->getString("aprs.packet.timestamp"));
-      v->add("cm", comment);
+    return is_posit_error;
+  } // Worker::checkForPositionErrors
 
-      v->compile(buf, "");
-      delete v;
+  bool Worker::getRemoteStation(const std::string &source, StationTable::station_t &ret) {
+    std::string buf;
+    PositionEntry entry;
+    if ( !_store->getPositionFromMemcached(openframe::StringTool::toLower(source), buf) ) return false;
+    if ( !RecordCodec::decode(buf, entry) ) return false;
+
+    ret.latitude = entry.latitude;
+    ret.longitude = entry.longitude;
+    ret.timestamp = entry.timestamp;
+    ret.comment = strtoull(entry.comment.c_str(), NULL, 16);
+    return true;
+  } // Worker::getRemoteStation
 
-      //_logf("key: %s, not found", result->_aprs->source().c_str());
+  void Worker::try_stations(const bool force) {
+    if (_pending_stations.empty()) return;
+    if (!force && !_stations_intval->is_next()) return;
 
-      _store->setPositionInMemcached(key, buf);
-    } // if
+    for(stations_itr itr = _pending_stations.begin(); itr != _pending_stations.end(); itr++) {
+      PositionEntry entry;
+      entry.source = itr->first;
+      entry.latitude = itr->second.latitude;
+      entry.longitude = itr->second.longitude;
+      entry.timestamp = itr->second.timestamp;
+      entry.comment = KeyHash::to_hex(itr->second.comment);
 
-    return is_posit_error;
-  } // Worker::checkForPositionErrors
+      _store->setPositionInMemcached(openframe::StringTool::toLower(itr->first), _store->codec().encode(entry) );
+    } // for
+
+    _stompstats.station_flushed += _pending_stations.size();
+    _pending_stations.clear();
+  } // Worker::try_stations
 
   void Worker::process(Result *result) {
     assert(result != NULL);		// bug
@@ -937,4 +1585,15 @@ namespace aprsinject {
 
     _locators.clear();
   } // worker::try_locators
+
+  void Worker::try_acks(const bool force) {
+    AckTracker::acks_t acks;
+    if (!_acks->collect(acks, force)) return;
+
+    for(AckTracker::acks_citr citr = acks.begin(); citr != acks.end(); citr++)
+      _input->ack(*citr);
+
+    _stats.acks += acks.size();
+    datapoint("num.acks.out", acks.size());
+  } // Worker::try_acks
 } // namespace aprsinject
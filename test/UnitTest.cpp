@@ -128,6 +128,13 @@ namespace aprsinject {
     _test("maxval:abs", "abcd", "max value bad vars string", false, true);
   } // UnitTest::_length
 
+  const bool UnitTest::check(const std::string &testName, const bool result) {
+    std::cout << (result ? " ok - " : " not ok - ") << testName << std::endl;
+    ok(result);
+
+    return result;
+  } // UnitTest::check
+
   const bool UnitTest::_test(const std::string &vars, const std::string &str, const std::string &testName, const bool expect, const bool exception) {
     bool isValid = true;
     Validator v = vars;
@@ -65,6 +65,8 @@ namespace aprsinject {
 
         _ok = ok;
       } // ok
+      // plain pass or fail for tests that aren't validator rules
+      const bool check(const std::string &testName, const bool result);
 
     protected:
       void _d();
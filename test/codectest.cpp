@@ -0,0 +1,373 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+#include <iostream>
+#include <string>
+
+#include <openframe/openframe.h>
+
+#include "UnitTest.h"
+#include "DBI.h"
+#include "RecordCodec.h"
+
+using namespace aprsinject;
+
+static const RecordCodec text(RecordCodec::formatText);
+static const RecordCodec binary(RecordCodec::formatBinary);
+
+// coordinates only survive to the microdegree either way
+static bool same_coord(const double a, const double b) {
+  double diff = a - b;
+  return diff < 0.0000011 && diff > -0.0000011;
+} // same_coord
+
+static LastpositionEntry make_lastposition(const std::string &source, const time_t timestamp) {
+  LastpositionEntry entry;
+  entry.source = source;
+  entry.timestamp = timestamp;
+  entry.latitude = 39.058833;
+  entry.longitude = -72.029167;
+  entry.callsign_id = 4294967301ULL;
+  entry.name_id = 12;
+  entry.packet_id = "8c7d3a2e-packet";
+  entry.path = "APRS,TCPIP*,qAC,T2TEST";
+  entry.course = "088";
+  entry.speed = "036";
+  entry.symbol_table = "/";
+  entry.symbol_code = ">";
+  entry.phg_range = "";
+  entry.phg_directivity = "";
+  entry.icon = "car.png";
+  entry.comment = "with, commas: colons|pipes";
+  return entry;
+} // make_lastposition
+
+static bool same_lastposition(const LastpositionEntry &a, const LastpositionEntry &b) {
+  return a.source == b.source
+         && a.timestamp == b.timestamp
+         && same_coord(a.latitude, b.latitude)
+         && same_coord(a.longitude, b.longitude)
+         && a.callsign_id == b.callsign_id
+         && a.name_id == b.name_id
+         && a.packet_id == b.packet_id
+         && a.name == b.name
+         && a.path == b.path
+         && a.course == b.course
+         && a.speed == b.speed
+         && a.altitude == b.altitude
+         && a.symbol_table == b.symbol_table
+         && a.symbol_code == b.symbol_code
+         && a.overlay == b.overlay
+         && a.icon == b.icon
+         && a.comment == b.comment;
+} // same_lastposition
+
+static void test_records(UnitTest &ut, const RecordCodec &codec, const std::string &name) {
+  DuplicateEntry dup;
+  dup.source = "N0CALL-9";
+  dup.timestamp = 1300000000;
+  dup.has_position = true;
+  dup.latitude = 49.058333;
+  dup.longitude = -72.029167;
+  std::string buf = codec.encode(dup);
+  ut.check(name+" duplicate is "+name, RecordCodec::is_binary(Slice(buf.data(), buf.length())) == (codec.format() == RecordCodec::formatBinary));
+
+  DuplicateEntry dup_out;
+  bool ok = RecordCodec::decode(buf, dup_out);
+  ut.check(name+" duplicate round trip", ok && dup_out.source == dup.source
+                                            && dup_out.timestamp == dup.timestamp
+                                            && dup_out.has_position
+                                            && same_coord(dup_out.latitude, dup.latitude)
+                                            && same_coord(dup_out.longitude, dup.longitude) );
+
+  dup.has_position = false;
+  buf = codec.encode(dup);
+  ok = RecordCodec::decode(buf, dup_out);
+  ut.check(name+" duplicate without position", ok && !dup_out.has_position);
+
+  PositionEntry pos;
+  pos.source = "N0CALL-9";
+  pos.latitude = -33.868820;
+  pos.longitude = 151.209296;
+  pos.timestamp = 1300000001;
+  pos.comment = "44bc2cf5ad770999";
+  buf = codec.encode(pos);
+
+  PositionEntry pos_out;
+  ok = RecordCodec::decode(buf, pos_out);
+  ut.check(name+" position round trip", ok && pos_out.source == pos.source
+                                           && same_coord(pos_out.latitude, pos.latitude)
+                                           && same_coord(pos_out.longitude, pos.longitude)
+                                           && pos_out.timestamp == pos.timestamp
+                                           && pos_out.comment == pos.comment);
+
+  Icon icon;
+  icon.id = "42";
+  icon.path = "/images/icons";
+  icon.image = "car.png";
+  icon.direction = "Y";
+  buf = codec.encode(icon);
+
+  Icon icon_out;
+  ok = RecordCodec::decode(buf, icon_out);
+  ut.check(name+" icon round trip", ok && icon_out.id == icon.id
+                                       && icon_out.path == icon.path
+                                       && icon_out.image == icon.image
+                                       && icon_out.direction == icon.direction);
+
+  // a record of one type doesn't decode as another
+  if (codec.format() == RecordCodec::formatBinary)
+    ut.check(name+" rejects the wrong type", !RecordCodec::decode(codec.encode(dup), pos_out) );
+} // test_records
+
+static void test_lists(UnitTest &ut, const RecordCodec &codec, const std::string &name) {
+  std::string buf;
+  codec.begin_list(buf, RecordCodec::typeLastpositions);
+  LastpositionEntry first = make_lastposition("N0CALL-9", 1300000010);
+  LastpositionEntry second = make_lastposition("N0CALL-1", 1300000005);
+  second.name = "OBJECT";
+  second.overlay = "D";
+  second.course = "";
+  codec.append(buf, first);
+  codec.append(buf, second);
+
+  RecordListReader reader(buf, RecordCodec::typeLastpositions);
+  ut.check(name+" lastpositions list format", reader.format() == codec.format() );
+
+  Slice entry;
+  std::string source;
+  time_t timestamp = 0;
+  LastpositionEntry out;
+  bool ok = reader.next(entry)
+            && RecordListReader::peek(entry, reader.format(), RecordCodec::typeLastpositions, source, timestamp)
+            && source == first.source && timestamp == first.timestamp
+            && RecordListReader::decode(entry, reader.format(), out)
+            && same_lastposition(out, first);
+  ut.check(name+" lastpositions first entry", ok);
+
+  out = LastpositionEntry();
+  ok = reader.next(entry)
+       && RecordListReader::decode(entry, reader.format(), out)
+       && same_lastposition(out, second);
+  ut.check(name+" lastpositions second entry", ok);
+  ut.check(name+" lastpositions end of list", !reader.next(entry) );
+
+  codec.begin_list(buf, RecordCodec::typeTrail);
+  TrailEntry trail;
+  trail.latitude = 51.477928;
+  trail.longitude = -0.001545;
+  trail.timestamp = 1300000020;
+  codec.append(buf, trail);
+
+  RecordListReader trail_reader(buf, RecordCodec::typeTrail);
+  TrailEntry trail_out;
+  timestamp = 0;
+  ok = trail_reader.next(entry)
+       && RecordListReader::peek(entry, trail_reader.format(), RecordCodec::typeTrail, source, timestamp)
+       && timestamp == trail.timestamp
+       && RecordListReader::decode(entry, trail_reader.format(), trail_out)
+       && same_coord(trail_out.latitude, trail.latitude)
+       && same_coord(trail_out.longitude, trail.longitude)
+       && trail_out.timestamp == trail.timestamp;
+  ut.check(name+" trail entry", ok && !trail_reader.next(entry) );
+
+  // a list of something else reads as empty
+  if (codec.format() == RecordCodec::formatBinary) {
+    RecordListReader wrong(buf, RecordCodec::typeLastpositions);
+    ut.check(name+" list of the wrong type is empty", !wrong.next(entry) );
+  } // if
+} // test_lists
+
+// Entries from either format end up in the other.
+static void test_cross(UnitTest &ut) {
+  LastpositionEntry lp = make_lastposition("N0CALL-9", 1300000030);
+
+  std::string from_text;
+  text.begin_list(from_text, RecordCodec::typeLastpositions);
+  text.append(from_text, lp);
+  std::string from_binary;
+  binary.begin_list(from_binary, RecordCodec::typeLastpositions);
+  binary.append(from_binary, lp);
+
+  const RecordCodec *codecs[] = { &text, &binary };
+  const std::string *sources[] = { &from_text, &from_binary };
+  const char *names[] = { "text", "binary" };
+  for(int to=0; to < 2; to++) {
+    for(int from=0; from < 2; from++) {
+      std::string buf;
+      codecs[to]->begin_list(buf, RecordCodec::typeLastpositions);
+
+      RecordListReader reader(*sources[from], RecordCodec::typeLastpositions);
+      Slice entry;
+      while(reader.next(entry))
+        codecs[to]->append(buf, RecordCodec::typeLastpositions, entry, reader.format() );
+
+      RecordListReader out_reader(buf, RecordCodec::typeLastpositions);
+      LastpositionEntry out;
+      bool ok = out_reader.format() == codecs[to]->format()
+                && out_reader.next(entry)
+                && RecordListReader::decode(entry, out_reader.format(), out)
+                && same_lastposition(out, lp)
+                && !out_reader.next(entry);
+      ut.check(std::string("append ")+names[from]+" entry to "+names[to]+" list", ok);
+    } // for
+  } // for
+
+  TrailEntry trail;
+  trail.latitude = 10.5;
+  trail.longitude = -20.25;
+  trail.timestamp = 1300000040;
+  std::string text_trail;
+  text.begin_list(text_trail, RecordCodec::typeTrail);
+  text.append(text_trail, trail);
+
+  std::string buf;
+  binary.begin_list(buf, RecordCodec::typeTrail);
+  RecordListReader reader(text_trail, RecordCodec::typeTrail);
+  Slice entry;
+  while(reader.next(entry))
+    binary.append(buf, RecordCodec::typeTrail, entry, reader.format() );
+
+  RecordListReader out_reader(buf, RecordCodec::typeTrail);
+  TrailEntry out;
+  bool ok = out_reader.next(entry)
+            && RecordListReader::decode(entry, out_reader.format(), out)
+            && same_coord(out.latitude, trail.latitude)
+            && out.timestamp == trail.timestamp;
+  ut.check("append text trail to binary list", ok);
+} // test_cross
+
+// A newer writer only ever appends fields, to a record or to a list
+// entry, and bumps the version.
+static void test_newer(UnitTest &ut) {
+  DuplicateEntry dup;
+  dup.source = "N0CALL-9";
+  dup.timestamp = 1300000050;
+  std::string buf = binary.encode(dup);
+  buf[1] = RecordCodec::kVersion + 1;
+  buf.append("\x07\x00newer!!", 9);
+
+  DuplicateEntry dup_out;
+  bool ok = RecordCodec::decode(buf, dup_out);
+  ut.check("newer duplicate record", ok && dup_out.source == dup.source && dup_out.timestamp == dup.timestamp);
+
+  LastpositionEntry first = make_lastposition("N0CALL-9", 1300000060);
+  LastpositionEntry second = make_lastposition("N0CALL-1", 1300000055);
+  std::string body;
+  binary.begin_list(body, RecordCodec::typeLastpositions);
+  binary.append(body, first);
+
+  // rewrite the first entry with four more bytes on the end
+  std::string list = body.substr(0, 3);
+  list[1] = RecordCodec::kVersion + 1;
+  size_t length = static_cast<unsigned char>(body[3]) | (static_cast<unsigned char>(body[4]) << 8);
+  length += 4;
+  list += static_cast<char>(length & 0xff);
+  list += static_cast<char>(length >> 8);
+  list.append(body, 5, std::string::npos);
+  list.append("\x01\x02\x03\x04", 4);
+  binary.append(list, second);
+
+  RecordListReader reader(list, RecordCodec::typeLastpositions);
+  Slice entry;
+  LastpositionEntry out;
+  ok = reader.next(entry)
+       && RecordListReader::decode(entry, reader.format(), out)
+       && same_lastposition(out, first);
+  ut.check("newer list entry skips appended fields", ok);
+
+  out = LastpositionEntry();
+  ok = reader.next(entry)
+       && RecordListReader::decode(entry, reader.format(), out)
+       && same_lastposition(out, second);
+  ut.check("newer list entry after appended fields", ok && !reader.next(entry) );
+} // test_newer
+
+static void test_truncated(UnitTest &ut) {
+  PositionEntry pos;
+  pos.source = "N0CALL-9";
+  pos.timestamp = 1300000070;
+  pos.comment = "44bc2cf5ad770999";
+  std::string buf = binary.encode(pos);
+
+  bool rejected = true;
+  PositionEntry out;
+  for(size_t length=3; length < buf.length(); length++)
+    rejected &= !RecordCodec::decode(buf.substr(0, length), out);
+  ut.check("truncated position rejected", rejected);
+
+  Icon icon;
+  icon.id = "42";
+  icon.path = "/images/icons";
+  icon.image = "car.png";
+  icon.direction = "N";
+  buf = binary.encode(icon);
+  Icon icon_out;
+  ut.check("truncated icon rejected", !RecordCodec::decode(buf.substr(0, buf.length() - 1), icon_out) );
+
+  LastpositionEntry first = make_lastposition("N0CALL-9", 1300000080);
+  binary.begin_list(buf, RecordCodec::typeLastpositions);
+  binary.append(buf, first);
+  size_t whole = buf.length();
+  binary.append(buf, make_lastposition("N0CALL-1", 1300000075) );
+
+  // the first entry still reads, the cut one ends the list
+  std::string cut = buf.substr(0, buf.length() - 5);
+  RecordListReader reader(cut, RecordCodec::typeLastpositions);
+  Slice entry;
+  LastpositionEntry lp;
+  bool ok = reader.next(entry)
+            && RecordListReader::decode(entry, reader.format(), lp)
+            && same_lastposition(lp, first);
+  ut.check("truncated list keeps whole entries", ok && !reader.next(entry) );
+
+  // a cut inside the length prefix too
+  cut = buf.substr(0, whole + 1);
+  RecordListReader short_reader(cut, RecordCodec::typeLastpositions);
+  ut.check("truncated list length prefix", short_reader.next(entry) && !short_reader.next(entry) );
+
+  // an entry whose length is right but whose fields are short
+  std::string list = buf.substr(0, 3);
+  list += '\x04';
+  list += '\x00';
+  list.append("\x08\x00N0", 4);
+  RecordListReader bad_reader(list, RecordCodec::typeLastpositions);
+  ok = bad_reader.next(entry) && !RecordListReader::decode(entry, bad_reader.format(), lp);
+  ut.check("truncated list entry fields rejected", ok);
+
+  DuplicateEntry dup;
+  ut.check("short header rejected", !RecordCodec::decode(std::string("\x01\x01", 2), dup) );
+} // test_truncated
+
+int main() {
+  UnitTest ut;
+
+  test_records(ut, text, "text");
+  test_records(ut, binary, "binary");
+  test_lists(ut, text, "text");
+  test_lists(ut, binary, "binary");
+  test_cross(ut);
+  test_newer(ut);
+  test_truncated(ut);
+
+  return ut.ok() ? 0 : 1;
+} // main
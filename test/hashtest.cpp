@@ -0,0 +1,60 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+#include <iostream>
+#include <string>
+
+#include <openframe/openframe.h>
+
+#include "UnitTest.h"
+#include "KeyHash.h"
+
+using aprsinject::KeyHash;
+
+int main() {
+  aprsinject::UnitTest ut;
+
+  // reference XXH64 values, seed 0
+  ut.check("hash empty", KeyHash::hash("") == 0xef46db3751d8e999ULL);
+  ut.check("hash short", KeyHash::hash("abc") == 0x44bc2cf5ad770999ULL);
+  ut.check("hash long", KeyHash::hash("Nobody inspects the spammish repetition") == 0xfbcea83c8a378bf1ULL);
+  ut.check("hash hex", KeyHash().update("abc").hex() == "44bc2cf5ad770999");
+
+  std::string packet = "N0CALL-9>APRS,TCPIP*:!4903.50N/07201.75W-PHG2360 Test ABCXYZ[]@`{ \xc3\x84";
+  std::string lower = packet;
+  for(std::string::size_type i=0; i < lower.length(); i++)
+    if (lower[i] >= 'A' && lower[i] <= 'Z') lower[i] += 0x20;
+
+  ut.check("hash folds ascii upper case", KeyHash::hash(packet, KeyHash::foldLower) == KeyHash::hash(lower));
+  ut.check("hash keeps case without fold", KeyHash::hash(packet) != KeyHash::hash(lower));
+
+  // however a key gets fed in it comes out the same
+  bool pieces = true;
+  for(std::string::size_type cut=0; cut <= packet.length(); cut++) {
+    KeyHash h(KeyHash::foldLower);
+    h.update(packet.data(), cut).update(packet.data() + cut, packet.length() - cut);
+    pieces &= h.digest() == KeyHash::hash(lower);
+  } // for
+  ut.check("hash split updates", pieces);
+
+  return ut.ok() ? 0 : 1;
+} // main
@@ -0,0 +1,151 @@
+/**************************************************************************
+ ** Dynamic Networking Solutions                                         **
+ **************************************************************************
+ ** OpenAPRS, Internet APRS MySQL Injector                               **
+ ** Copyright (C) 1999 Gregory A. Carter                                 **
+ **                    Dynamic Networking Solutions                      **
+ **                                                                      **
+ ** This program is free software; you can redistribute it and/or modify **
+ ** it under the terms of the GNU General Public License as published by **
+ ** the Free Software Foundation; either version 1, or (at your option)  **
+ ** any later version.                                                   **
+ **                                                                      **
+ ** This program is distributed in the hope that it will be useful,      **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of       **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        **
+ ** GNU General Public License for more details.                         **
+ **                                                                      **
+ ** You should have received a copy of the GNU General Public License    **
+ ** along with this program; if not, write to the Free Software          **
+ ** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.            **
+ **************************************************************************/
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <openframe/openframe.h>
+
+#include "UnitTest.h"
+#include "IdSnapshot.h"
+
+using namespace aprsinject;
+
+static IdSnapshot::entry_t entry(const IdCache::key_t key, const sqlid_t id) {
+  IdSnapshot::entry_t ret;
+  ret.key = key;
+  ret.id = id;
+  return ret;
+} // entry
+
+// rewrites the file with its bytes from offset replaced or cut
+static bool mangle(const std::string &from, const std::string &to, const long offset, const std::string &bytes, const bool cut) {
+  FILE *fp = fopen(from.c_str(), "rb");
+  if (fp == NULL) return false;
+  std::string buf;
+  char chunk[4096];
+  size_t n;
+  while((n = fread(chunk, 1, sizeof(chunk), fp)) > 0) buf.append(chunk, n);
+  fclose(fp);
+
+  if (cut) buf.erase(offset);
+  else buf.replace(offset, bytes.length(), bytes);
+
+  fp = fopen(to.c_str(), "wb");
+  if (fp == NULL) return false;
+  bool ok = fwrite(buf.data(), 1, buf.length(), fp) == buf.length();
+  fclose(fp);
+  return ok;
+} // mangle
+
+int main() {
+  UnitTest ut;
+
+  char path_buf[] = "/tmp/snapshottest.XXXXXX";
+  int fd = mkstemp(path_buf);
+  if (fd == -1) {
+    std::cout << " not ok - could not create a temporary file" << std::endl;
+    return 1;
+  } // if
+  close(fd);
+  std::string path = path_buf;
+  std::string bad = path + ".bad";
+
+  // the same keys in different namespaces are different names, a key
+  // repeated in one namespace keeps the first id it was given
+  IdSnapshot::entries_t entries[IdCache::nsMax];
+  entries[IdCache::nsCallsign].push_back( entry(300, 3) );
+  entries[IdCache::nsCallsign].push_back( entry(100, 1) );
+  entries[IdCache::nsCallsign].push_back( entry(200, 2) );
+  entries[IdCache::nsCallsign].push_back( entry(100, 99) );
+  entries[IdCache::nsDigi].push_back( entry(100, 7) );
+  entries[IdCache::nsDigi].push_back( entry(0xffffffffffffffffULL, 4294967301ULL) );
+  entries[IdCache::nsMaidenhead].push_back( entry(5, 50) );
+  entries[IdCache::nsMaidenhead].push_back( entry(5, 51) );
+  entries[IdCache::nsMaidenhead].push_back( entry(5, 52) );
+
+  std::string error;
+  ut.check("snapshot write", IdSnapshot::write(path, entries, error) );
+  ut.check("snapshot write leaves no temporary", access( (path + ".tmp").c_str(), F_OK) == -1);
+
+  IdSnapshot snapshot;
+  ut.check("snapshot open", snapshot.open(path) );
+  ut.check("snapshot sizes", snapshot.size(IdCache::nsCallsign) == 3
+                             && snapshot.size(IdCache::nsDigi) == 2
+                             && snapshot.size(IdCache::nsMaidenhead) == 1
+                             && snapshot.size(IdCache::nsName) == 0
+                             && snapshot.size() == 6);
+  ut.check("snapshot max ids", snapshot.max_id(IdCache::nsCallsign) == 3
+                               && snapshot.max_id(IdCache::nsDigi) == 4294967301ULL
+                               && snapshot.max_id(IdCache::nsMaidenhead) == 50
+                               && snapshot.max_id(IdCache::nsDest) == 0);
+
+  sqlid_t id = 0;
+  ut.check("snapshot find", snapshot.find(IdCache::nsCallsign, 200, id) && id == 2);
+  ut.check("snapshot first id wins", snapshot.find(IdCache::nsCallsign, 100, id) && id == 1);
+  ut.check("snapshot first id wins again", snapshot.find(IdCache::nsMaidenhead, 5, id) && id == 50);
+  ut.check("snapshot keys per namespace", snapshot.find(IdCache::nsDigi, 100, id) && id == 7);
+  ut.check("snapshot largest key", snapshot.find(IdCache::nsDigi, 0xffffffffffffffffULL, id) && id == 4294967301ULL);
+  ut.check("snapshot missing key", !snapshot.find(IdCache::nsCallsign, 150, id)
+                                   && !snapshot.find(IdCache::nsCallsign, 400, id)
+                                   && !snapshot.find(IdCache::nsName, 100, id) );
+
+  IdSnapshot::entries_t copied;
+  snapshot.copy(IdCache::nsCallsign, copied);
+  ut.check("snapshot copy is sorted", copied.size() == 3
+                                      && copied[0].key == 100 && copied[1].key == 200 && copied[2].key == 300);
+  snapshot.close();
+  ut.check("snapshot close", !snapshot.is_open() );
+
+  IdSnapshot rejected;
+  // header is the magic then the version
+  ut.check("snapshot wrong version written", mangle(path, bad, 4, std::string("\xff\xff\xff\xff", 4), false) );
+  ut.check("snapshot wrong version rejected", !rejected.open(bad) && !rejected.last_error().empty() );
+
+  ut.check("snapshot wrong magic written", mangle(path, bad, 0, std::string("\0\0\0\0", 4), false) );
+  ut.check("snapshot wrong magic rejected", !rejected.open(bad) );
+
+  ut.check("snapshot empty written", mangle(path, bad, 0, "", true) );
+  ut.check("snapshot empty rejected", !rejected.open(bad) );
+
+  // short a single entry off the end
+  FILE *fp = fopen(path.c_str(), "rb");
+  fseek(fp, 0, SEEK_END);
+  long length = ftell(fp);
+  fclose(fp);
+  ut.check("snapshot cut entry written", mangle(path, bad, length - sizeof(IdSnapshot::entry_t), "", true) );
+  ut.check("snapshot cut entry rejected", !rejected.open(bad) && !rejected.is_open() );
+
+  ut.check("snapshot cut header written", mangle(path, bad, 12, "", true) );
+  ut.check("snapshot cut header rejected", !rejected.open(bad) );
+
+  ut.check("snapshot missing file rejected", !rejected.open(path + ".missing") );
+
+  unlink( bad.c_str() );
+  unlink( path.c_str() );
+
+  return ut.ok() ? 0 : 1;
+} // main